@@ -0,0 +1,72 @@
+//
+//    FILE: Arduino.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the ESP32 Arduino core, including the main() that drives setup() and loop()
+//
+
+#include "Arduino.h"
+
+#include <random>
+
+#include "hal_native_internal.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static std::mt19937 rng(0);
+
+uint32_t millis(void) {
+  return (uint32_t)(hal_native::micros64() / 1000);
+}
+
+uint32_t micros(void) {
+  return (uint32_t)hal_native::micros64();
+}
+
+void delay(uint32_t ms) {
+  hal_native::sleep_ms(ms);
+}
+
+void yield(void) {
+}
+
+uint32_t EspClass::getCycleCount(void) {
+  return (uint32_t)(hal_native::host_ns() * getCpuFreqMHz() / 1000);
+}
+
+long random(long howbig) {
+  if (howbig <= 0) return 0;
+  return (long)(rng() % (uint32_t)howbig);
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+  rng.seed(seed);
+}
+
+size_t HardwareSerial::printf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int len = vprintf(format, args);
+  va_end(args);
+  return len > 0 ? len : 0;
+}
+
+// Under pio test the test runner has its own main(), and there is no setup() or loop()
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char **argv) {
+  hal_native::init(argc, argv);
+  setup();
+  while (!hal_native::should_exit())
+    loop();
+  hal_native::stop_tasks();
+  fflush(stdout);
+  return 0;
+}
+#endif
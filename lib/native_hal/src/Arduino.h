@@ -0,0 +1,90 @@
+#pragma once
+//
+//    FILE: Arduino.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the subset of the ESP32 Arduino core used by the CO2 monitor
+//
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "freertos/FreeRTOS.h"  // The ESP32 Arduino core includes FreeRTOS for every sketch
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "hal_native.h"
+
+#define PROGMEM
+#define IRAM_ATTR
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// Timing
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void yield(void);
+
+// Random numbers, same semantics as the Arduino core
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// ESP32 time zone and SNTP helper from esp32-hal-time.c
+void configTzTime(const char *tz, const char *server1, const char *server2 = nullptr, const char *server3 = nullptr);
+
+// ESP32 chip information, the cycle counter counts host time at the Core2's 240 MHz, so it
+// measures work done by the firmware but not delay() or NATIVE_TIME_SCALE
+class EspClass {
+ public:
+  uint32_t getCycleCount(void);
+  uint32_t getCpuFreqMHz(void) { return 240; }
+};
+extern EspClass ESP;
+
+// Serial port stand-in writes to stdout
+class HardwareSerial {
+ public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  size_t print(const char *s) { return fputs(s, stdout) >= 0 ? strlen(s) : 0; }
+  size_t print(char c) { return fputc(c, stdout) != EOF; }
+  size_t print(int n) { return printf("%d", n); }
+  size_t print(unsigned int n) { return printf("%u", n); }
+  size_t print(long n) { return printf("%ld", n); }
+  size_t print(unsigned long n) { return printf("%lu", n); }
+  size_t print(double n, int digits = 2) { return printf("%.*f", digits, n); }
+  size_t println(void) { return print("\n"); }
+  template <typename T>
+  size_t println(T v) { return print(v) + println(); }
+  void flush(void) { fflush(stdout); }
+};
+extern HardwareSerial Serial;
+
+// ESP-IDF style log macros, filtered by CORE_DEBUG_LEVEL as on the ESP32
+#ifndef CORE_DEBUG_LEVEL
+  #define CORE_DEBUG_LEVEL 0
+#endif
+#define native_log(level, letter, format, ...)                                             \
+  do {                                                                                     \
+    if (CORE_DEBUG_LEVEL >= level) fprintf(stderr, "[" letter "] " format "\n", ##__VA_ARGS__); \
+  } while (0)
+#define log_e(format, ...) native_log(1, "E", format, ##__VA_ARGS__)
+#define log_w(format, ...) native_log(2, "W", format, ##__VA_ARGS__)
+#define log_i(format, ...) native_log(3, "I", format, ##__VA_ARGS__)
+#define log_d(format, ...) native_log(4, "D", format, ##__VA_ARGS__)
+#define log_v(format, ...) native_log(5, "V", format, ##__VA_ARGS__)
+
+// Firmware entry points, called by the native main()
+void setup(void);
+void loop(void);
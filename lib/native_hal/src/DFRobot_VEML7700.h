@@ -0,0 +1,25 @@
+#pragma once
+//
+//    FILE: DFRobot_VEML7700.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the VEML7700 ambient light sensor, reports a fixed office light level
+//
+
+#include "Wire.h"
+
+class DFRobot_VEML7700 {
+ public:
+  void begin(void) {}
+  uint8_t getALSLux(float &lux) {
+    hal_native::i2c_count(true);
+    lux = _lux;
+    return 0;
+  }
+  uint8_t getAutoALSLux(float &lux) { return getALSLux(lux); }
+  void setLux(float lux) { _lux = lux; }
+
+ private:
+  float _lux = 150.0f;
+};
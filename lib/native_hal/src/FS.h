@@ -0,0 +1,65 @@
+#pragma once
+//
+//    FILE: FS.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the ESP32 fs::FS / fs::File API, backed by a host directory
+//
+// Paths such as "/co2_hist.bin" are resolved under the host directory the file system was
+// mounted on. Every write() is reported through hal_native::sd_count_write() so the number of
+// card writes can be measured on a desktop.
+//
+
+#include <memory>
+#include <string>
+
+#include "Arduino.h"
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0,
+                SeekCur = 1,
+                SeekEnd = 2 };
+
+class File {
+ public:
+  File(void) {}
+  File(FILE *fp);
+
+  size_t write(const uint8_t *buf, size_t size);
+  size_t read(uint8_t *buf, size_t size);
+  bool seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position(void) const;
+  size_t size(void) const;
+  void flush(void);
+  void close(void) { _fp.reset(); }
+  operator bool() const { return _fp != nullptr; }
+
+ private:
+  std::shared_ptr<FILE> _fp;
+};
+
+class FS {
+ public:
+  File open(const char *path, const char *mode = FILE_READ, const bool create = false);
+  bool exists(const char *path);
+  bool remove(const char *path);
+  bool mkdir(const char *path);
+
+ protected:
+  bool mount(const char *host_dir);
+  void unmount(void) { _root.clear(); }
+  std::string host_path(const char *path) const { return _root + path; }
+
+  std::string _root;  // Host directory, empty when not mounted
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
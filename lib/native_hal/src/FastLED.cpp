@@ -0,0 +1,11 @@
+//
+//    FILE: FastLED.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for FastLED
+//
+
+#include "FastLED.h"
+
+CFastLED FastLED;
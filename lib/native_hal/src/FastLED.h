@@ -0,0 +1,69 @@
+#pragma once
+//
+//    FILE: FastLED.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the subset of FastLED used by the CO2 monitor
+//
+
+#include "Arduino.h"
+
+enum EOrder { RGB = 0012,
+              GRB = 0102 };
+
+struct CRGB {
+  uint8_t r = 0;
+  uint8_t g = 0;
+  uint8_t b = 0;
+
+  CRGB(void) = default;
+  CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+  bool operator==(const CRGB &rhs) const { return r == rhs.r && g == rhs.g && b == rhs.b; }
+
+  enum HTMLColorCode {
+    Black = 0x000000,
+    Blue = 0x0000FF,
+    Fuchsia = 0xFF00FF,
+    Green = 0x008000,
+    Orange = 0xFFA500,
+    Pink = 0xFFC0CB,
+    Red = 0xFF0000,
+    White = 0xFFFFFF,
+    Yellow = 0xFFFF00,
+  };
+};
+
+template <uint8_t DATA_PIN, EOrder RGB_ORDER = GRB>
+class WS2812 {};
+
+// LED strip controller, show() counts frames instead of driving the RMT peripheral
+class CFastLED {
+ public:
+  template <template <uint8_t, EOrder> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+  CFastLED &addLeds(CRGB *leds, int count) {
+    _leds = leds;
+    _count = count;
+    return *this;
+  }
+  void setBrightness(uint8_t scale) { _brightness = scale; }
+  uint8_t getBrightness(void) const { return _brightness; }
+  void show(void) { _frames++; }
+  uint32_t frames(void) const { return _frames; }
+  const CRGB *leds(void) const { return _leds; }
+  int count(void) const { return _count; }
+
+ private:
+  CRGB *_leds = nullptr;
+  int _count = 0;
+  uint8_t _brightness = 255;
+  uint32_t _frames = 0;
+};
+
+extern CFastLED FastLED;
+
+inline void fill_solid(CRGB *leds, int count, const CRGB &colour) {
+  for (int i = 0; i < count; i++)
+    leds[i] = colour;
+}
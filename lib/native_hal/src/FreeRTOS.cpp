@@ -0,0 +1,83 @@
+//
+//    FILE: FreeRTOS.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for FreeRTOS tasks and mutexes, backed by std::thread and std::timed_mutex
+//
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "hal_native_internal.h"
+
+#define loop_task_core 1  // ESP32 Arduino core runs setup() and loop() on core 1
+
+static thread_local BaseType_t core = loop_task_core;
+static std::atomic<bool> stopping{false};
+static std::atomic<int> tasks_running{0};
+static std::atomic<int> tasks_parked{0};
+static std::atomic<uintptr_t> last_handle{0};
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stack_depth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id) {
+  (void)name;
+  (void)stack_depth;
+  (void)priority;
+  tasks_running++;
+  std::thread thread([=] {
+    core = core_id;
+    task(param);
+    tasks_running--;  // A FreeRTOS task must not return, but don't hang the exit if it does
+  });
+  if (handle) *handle = (TaskHandle_t)++last_handle;  // Only compared against nullptr by the firmware
+  thread.detach();
+  return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  // Once loop() has stopped, park the task here so it is idle while static objects are destroyed
+  if (stopping) {
+    tasks_parked++;
+    for (;;)
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+  }
+  hal_native::task_sleep_ms(ticks * portTICK_PERIOD_MS);
+}
+
+BaseType_t xPortGetCoreID(void) {
+  return core;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+  return new std::timed_mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+  auto *m = static_cast<std::timed_mutex *>(mutex);
+  if (ticks == portMAX_DELAY) {
+    m->lock();
+    return pdTRUE;
+  }
+  return m->try_lock_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+  static_cast<std::timed_mutex *>(mutex)->unlock();
+  return pdTRUE;
+}
+
+namespace hal_native {
+
+void stop_tasks(void) {
+  stopping = true;
+  // Wait (host time) for each task to reach its next vTaskDelay()
+  for (int i = 0; i < 1000 && tasks_parked < tasks_running; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+}  // namespace hal_native
@@ -0,0 +1,398 @@
+//
+//    FILE: M5Unified.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for M5Unified / M5GFX: frame buffer drawing, RTC, buttons and touch
+//
+
+#include "M5Unified.h"
+
+#include "hal_native_internal.h"
+
+m5::M5Unified M5;
+
+// Built-in fonts have no glyph tables, only the line height of the real font
+namespace fonts {
+const GFXfont Font0 = {nullptr, nullptr, 0x20, 0x7E, 8};
+const GFXfont FreeSans9pt7b = {nullptr, nullptr, 0x20, 0x7E, 22};
+const GFXfont FreeSans12pt7b = {nullptr, nullptr, 0x20, 0x7E, 29};
+const GFXfont FreeSans18pt7b = {nullptr, nullptr, 0x20, 0x7E, 42};
+const GFXfont FreeSans24pt7b = {nullptr, nullptr, 0x20, 0x7E, 56};
+const GFXfont FreeSansBold12pt7b = {nullptr, nullptr, 0x20, 0x7E, 29};
+const GFXfont FreeSansBold24pt7b = {nullptr, nullptr, 0x20, 0x7E, 56};
+}  // namespace fonts
+
+/////////////////////////////////////////////////////
+//
+// FRAME BUFFER
+//
+NativeGFX::NativeGFX(int32_t w, int32_t h) : _font(&fonts::Font0) {
+  resize(w, h);
+}
+
+void NativeGFX::resize(int32_t w, int32_t h) {
+  _width = w;
+  _height = h;
+  _fb.assign((size_t)w * h, 0);
+  clearClipRect();
+  clearScrollRect();
+}
+
+void NativeGFX::setClipRect(int32_t x, int32_t y, int32_t w, int32_t h) {
+  _clip_x0 = std::max<int32_t>(x, 0);
+  _clip_y0 = std::max<int32_t>(y, 0);
+  _clip_x1 = std::min<int32_t>(x + w, _width);
+  _clip_y1 = std::min<int32_t>(y + h, _height);
+}
+
+void NativeGFX::setScrollRect(int32_t x, int32_t y, int32_t w, int32_t h) {
+  _scroll_x = x;
+  _scroll_y = y;
+  _scroll_w = w;
+  _scroll_h = h;
+}
+
+void NativeGFX::scroll(int32_t dx, int32_t dy) {
+  int32_t x0 = std::max<int32_t>(_scroll_x, 0), x1 = std::min<int32_t>(_scroll_x + _scroll_w, _width);
+  int32_t y0 = std::max<int32_t>(_scroll_y, 0), y1 = std::min<int32_t>(_scroll_y + _scroll_h, _height);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  // Build the scrolled rectangle separately so overlapping source pixels are not overwritten early
+  std::vector<uint16_t> out((size_t)(x1 - x0) * (y1 - y0), TFT_BLACK);
+  for (int32_t y = y0; y < y1; y++) {
+    int32_t sy = y - dy;
+    if (sy < y0 || sy >= y1) continue;
+    for (int32_t x = x0; x < x1; x++) {
+      int32_t sx = x - dx;
+      if (sx >= x0 && sx < x1) out[(size_t)(y - y0) * (x1 - x0) + (x - x0)] = _fb[(size_t)sy * _width + sx];
+    }
+  }
+  for (int32_t y = y0; y < y1; y++)
+    std::copy(&out[(size_t)(y - y0) * (x1 - x0)], &out[(size_t)(y - y0 + 1) * (x1 - x0)], &_fb[(size_t)y * _width + x0]);
+  _pixels_written += (x1 - x0) * (y1 - y0);
+}
+
+uint16_t NativeGFX::readPixel(int32_t x, int32_t y) const {
+  if (x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+  return _fb[(size_t)y * _width + x];
+}
+
+void NativeGFX::drawPixel(int32_t x, int32_t y, uint32_t colour) {
+  if (x < _clip_x0 || y < _clip_y0 || x >= _clip_x1 || y >= _clip_y1) return;
+  _fb[(size_t)y * _width + x] = (uint16_t)colour;
+  _pixels_written++;
+}
+
+void NativeGFX::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t colour) {
+  int32_t x0 = std::max<int32_t>(x, _clip_x0);
+  int32_t y0 = std::max<int32_t>(y, _clip_y0);
+  int32_t x1 = std::min<int32_t>(x + w, _clip_x1);
+  int32_t y1 = std::min<int32_t>(y + h, _clip_y1);
+  if (x0 >= x1 || y0 >= y1) return;
+  for (int32_t yy = y0; yy < y1; yy++)
+    std::fill(&_fb[(size_t)yy * _width + x0], &_fb[(size_t)yy * _width + x1], (uint16_t)colour);
+  _pixels_written += (x1 - x0) * (y1 - y0);
+}
+
+void NativeGFX::pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) {
+  for (int32_t yy = 0; yy < h; yy++)
+    for (int32_t xx = 0; xx < w; xx++)
+      drawPixel(x + xx, y + yy, data[(size_t)yy * w + xx]);
+}
+
+void NativeGFX::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t colour) {
+  fillRect(x, y, w, 1, colour);
+  fillRect(x, y + h - 1, w, 1, colour);
+  fillRect(x, y, 1, h, colour);
+  fillRect(x + w - 1, y, 1, h, colour);
+}
+
+void NativeGFX::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t colour) {
+  (void)r;  // Corners are square in the stand-in
+  fillRect(x, y, w, h, colour);
+}
+
+void NativeGFX::drawCircle(int32_t x, int32_t y, int32_t r, uint32_t colour) {
+  int32_t dx = r, dy = 0, err = 1 - r;
+  while (dx >= dy) {
+    drawPixel(x + dx, y + dy, colour);
+    drawPixel(x - dx, y + dy, colour);
+    drawPixel(x + dx, y - dy, colour);
+    drawPixel(x - dx, y - dy, colour);
+    drawPixel(x + dy, y + dx, colour);
+    drawPixel(x - dy, y + dx, colour);
+    drawPixel(x + dy, y - dx, colour);
+    drawPixel(x - dy, y - dx, colour);
+    dy++;
+    if (err < 0)
+      err += 2 * dy + 1;
+    else {
+      dx--;
+      err += 2 * (dy - dx) + 1;
+    }
+  }
+}
+
+void NativeGFX::fillCircle(int32_t x, int32_t y, int32_t r, uint32_t colour) {
+  for (int32_t dy = -r; dy <= r; dy++) {
+    int32_t dx = (int32_t)sqrtf((float)(r * r - dy * dy));
+    fillRect(x - dx, y + dy, 2 * dx + 1, 1, colour);
+  }
+}
+
+void NativeGFX::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t colour) {
+  int32_t dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  int32_t dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  int32_t err = dx + dy;
+  while (true) {
+    drawPixel(x0, y0, colour);
+    if (x0 == x1 && y0 == y1) break;
+    int32_t e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x0 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+}
+
+void NativeGFX::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t colour) {
+  int32_t min_x = std::min({x0, x1, x2}), max_x = std::max({x0, x1, x2});
+  int32_t min_y = std::min({y0, y1, y2}), max_y = std::max({y0, y1, y2});
+  int32_t area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+  if (area == 0) return;
+  for (int32_t y = min_y; y <= max_y; y++) {
+    for (int32_t x = min_x; x <= max_x; x++) {
+      int32_t w0 = (x1 - x) * (y2 - y) - (x2 - x) * (y1 - y);
+      int32_t w1 = (x2 - x) * (y0 - y) - (x0 - x) * (y2 - y);
+      int32_t w2 = (x0 - x) * (y1 - y) - (x1 - x) * (y0 - y);
+      if ((area > 0 && w0 >= 0 && w1 >= 0 && w2 >= 0) || (area < 0 && w0 <= 0 && w1 <= 0 && w2 <= 0))
+        drawPixel(x, y, colour);
+    }
+  }
+}
+
+// Angles in degrees, 0° = EAST, increasing clockwise, as in LovyanGFX
+void NativeGFX::fillArc(int32_t x, int32_t y, int32_t r0, int32_t r1, float angle0, float angle1, uint32_t colour) {
+  if (r0 > r1) std::swap(r0, r1);
+  float span = angle1 - angle0;
+  while (span < 0) span += 360.0f;
+  for (int32_t dy = -r1; dy <= r1; dy++) {
+    for (int32_t dx = -r1; dx <= r1; dx++) {
+      int32_t d2 = dx * dx + dy * dy;
+      if (d2 < r0 * r0 || d2 > r1 * r1) continue;
+      float a = atan2f((float)dy, (float)dx) * 180.0f / (float)M_PI - angle0;
+      while (a < 0) a += 360.0f;
+      if (a <= span) drawPixel(x + dx, y + dy, colour);
+    }
+  }
+}
+
+void NativeGFX::drawArc(int32_t x, int32_t y, int32_t r0, int32_t r1, float angle0, float angle1, uint32_t colour) {
+  fillArc(x, y, r0, r0, angle0, angle1, colour);
+  fillArc(x, y, r1, r1, angle0, angle1, colour);
+}
+
+/////////////////////////////////////////////////////
+//
+// TEXT
+//
+int32_t NativeGFX::textWidth(const char *str) const {
+  int32_t w = 0;
+  for (const char *c = str; *c; c++) {
+    if (_font->glyph != nullptr && *c >= _font->first && *c <= _font->last)
+      w += _font->glyph[*c - _font->first].xAdvance;
+    else
+      w += (_font->yAdvance * 11) / 20;  // Typical advance of a proportional sans font
+  }
+  return w;
+}
+
+int32_t NativeGFX::drawChar(char c, int32_t x, int32_t y) {
+  int32_t baseline = y + (_font->yAdvance * 3) / 4;
+  if (_font->glyph == nullptr || c < _font->first || c > _font->last) {
+    int32_t adv = (_font->yAdvance * 11) / 20;
+    if (c != ' ') fillRect(x + 1, y + _font->yAdvance / 4, adv - 2, _font->yAdvance / 2, _text_fg);
+    return adv;
+  }
+
+  const GFXglyph &g = _font->glyph[c - _font->first];
+  const uint8_t *bits = &_font->bitmap[g.bitmapOffset];
+  uint32_t bit = 0;
+  for (int32_t yy = 0; yy < g.height; yy++) {
+    for (int32_t xx = 0; xx < g.width; xx++, bit++) {
+      if (bits[bit >> 3] & (0x80 >> (bit & 7)))
+        drawPixel(x + g.xOffset + xx, baseline + g.yOffset + yy, _text_fg);
+    }
+  }
+  return g.xAdvance;
+}
+
+size_t NativeGFX::drawString(const char *str, int32_t x, int32_t y) {
+  int32_t w = textWidth(str);
+  int32_t h = fontHeight();
+  int32_t pad_w = std::max<int32_t>(w, (int32_t)_padding);
+  uint8_t horiz = _datum & 3;
+  uint8_t vert = _datum & 12;
+
+  if (vert == middle_left) y -= h / 2;
+  if (vert == bottom_left) y -= h;
+
+  int32_t text_x = x, pad_x = x;
+  if (horiz == top_center) {
+    text_x = x - w / 2;
+    pad_x = x - pad_w / 2;
+  } else if (horiz == top_right) {
+    text_x = x - w;
+    pad_x = x - pad_w;
+  }
+
+  if (_text_bg_set) fillRect(pad_x, y, pad_w, h, _text_bg);
+  for (const char *c = str; *c; c++)
+    text_x += drawChar(*c, text_x, y);
+  return w;
+}
+
+size_t NativeGFX::print(const char *str) {
+  for (const char *c = str; *c; c++)
+    _cursor_x += drawChar(*c, _cursor_x, _cursor_y);
+  return strlen(str);
+}
+
+/////////////////////////////////////////////////////
+//
+// SPRITES
+//
+void *M5Canvas::createSprite(int32_t w, int32_t h) {
+  resize(w, h);
+  return _fb.data();
+}
+
+// Only the part inside the destination's clip rectangle is sent, as on the LCD
+void M5Canvas::pushSprite(NativeGFX *dst, int32_t x, int32_t y) {
+  if (dst == nullptr) return;
+  int32_t cx, cy, cw, ch;
+  dst->getClipRect(&cx, &cy, &cw, &ch);
+  int32_t y0 = std::max<int32_t>(0, cy - y), y1 = std::min<int32_t>(_height, cy + ch - y);
+  int32_t x0 = std::max<int32_t>(0, cx - x), x1 = std::min<int32_t>(_width, cx + cw - x);
+  for (int32_t yy = y0; yy < y1; yy++)
+    for (int32_t xx = x0; xx < x1; xx++)
+      dst->drawPixel(x + xx, y + yy, _fb[(size_t)yy * _width + xx]);
+}
+
+// Sprite pivot is placed at (x, y) on the destination and rotated clockwise by angle degrees
+void M5Canvas::rotate_zoom(NativeGFX *dst, float x, float y, float angle, float zoom_x, float zoom_y, bool use_transp, uint32_t transp) {
+  if (dst == nullptr || zoom_x == 0 || zoom_y == 0) return;
+  float rad = angle * (float)M_PI / 180.0f;
+  float c = cosf(rad), s = sinf(rad);
+
+  // Destination bounding box of the four rotated corners
+  float min_x = 1e9f, max_x = -1e9f, min_y = 1e9f, max_y = -1e9f;
+  const float corners[4][2] = {{0, 0}, {(float)_width, 0}, {0, (float)_height}, {(float)_width, (float)_height}};
+  for (auto &p : corners) {
+    float dx = (p[0] - _pivot_x) * zoom_x, dy = (p[1] - _pivot_y) * zoom_y;
+    float rx = x + dx * c - dy * s, ry = y + dx * s + dy * c;
+    min_x = std::min(min_x, rx);
+    max_x = std::max(max_x, rx);
+    min_y = std::min(min_y, ry);
+    max_y = std::max(max_y, ry);
+  }
+
+  // Inverse map each destination pixel back into the sprite
+  for (int32_t yy = (int32_t)floorf(min_y); yy <= (int32_t)ceilf(max_y); yy++) {
+    for (int32_t xx = (int32_t)floorf(min_x); xx <= (int32_t)ceilf(max_x); xx++) {
+      float dx = xx - x, dy = yy - y;
+      int32_t sx = (int32_t)floorf((dx * c + dy * s) / zoom_x + _pivot_x);
+      int32_t sy = (int32_t)floorf((-dx * s + dy * c) / zoom_y + _pivot_y);
+      if (sx < 0 || sy < 0 || sx >= _width || sy >= _height) continue;
+      uint16_t colour = _fb[(size_t)sy * _width + sx];
+      if (use_transp && colour == (uint16_t)transp) continue;
+      dst->drawPixel(xx, yy, colour);
+    }
+  }
+}
+
+namespace m5 {
+
+/////////////////////////////////////////////////////
+//
+// RTC
+//
+time_t RTC_Class::now(void) {
+  return hal_native::rtc_boot_epoch() + _offset_s + (time_t)(millis() / 1000);
+}
+
+rtc_datetime_t RTC_Class::getDateTime(void) {
+  rtc_datetime_t dt;
+  getDate(&dt.date);
+  getTime(&dt.time);
+  return dt;
+}
+
+bool RTC_Class::getTime(rtc_time_t *t) {
+  time_t epoch = now();
+  struct tm tm_now;
+  localtime_r(&epoch, &tm_now);
+  t->hours = tm_now.tm_hour;
+  t->minutes = tm_now.tm_min;
+  t->seconds = tm_now.tm_sec;
+  return true;
+}
+
+bool RTC_Class::getDate(rtc_date_t *d) {
+  time_t epoch = now();
+  struct tm tm_now;
+  localtime_r(&epoch, &tm_now);
+  d->weekDay = tm_now.tm_wday;
+  d->month = tm_now.tm_mon + 1;
+  d->date = tm_now.tm_mday;
+  d->year = tm_now.tm_year + 1900;
+  return true;
+}
+
+void RTC_Class::setDateTime(const tm *datetime) {
+  struct tm copy = *datetime;
+  _offset_s = (int64_t)mktime(&copy) - (int64_t)(hal_native::rtc_boot_epoch() + millis() / 1000);
+}
+
+/////////////////////////////////////////////////////
+//
+// BUTTONS AND TOUCH
+//
+void Button_Class::setRawState(uint32_t msec, bool press) {
+  if (!press && _press) _last_hold_ms = _hold_ms;
+  _last_press = _press;
+  _press = press;
+  if (press && !_last_press) _press_start = msec;
+  _hold_ms = press ? msec - _press_start : 0;
+}
+
+void Touch_Class::update(void) {
+  auto &input = hal_native::pending_input();
+  _detail.pressed = input.tap;
+  if (input.tap) {
+    _detail.x = input.tap_x;
+    _detail.y = input.tap_y;
+    input.tap = false;
+  }
+}
+
+void M5Unified::begin(config_t cfg) {
+  Serial.begin(cfg.serial_baudrate);
+  if (cfg.clear_display) Lcd.clear();
+}
+
+void M5Unified::update(void) {
+  auto &input = hal_native::pending_input();
+  uint32_t now = millis();
+  Button_Class *buttons[3] = {&BtnA, &BtnB, &BtnC};
+  for (int i = 0; i < 3; i++)
+    buttons[i]->setRawState(now, now >= input.hold_start[i] && now < input.hold_until[i]);
+  Touch.update();
+}
+
+}  // namespace m5
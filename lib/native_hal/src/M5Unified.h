@@ -0,0 +1,360 @@
+#pragma once
+//
+//    FILE: M5Unified.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the subset of M5Unified / M5GFX used by the CO2 monitor
+//
+// The LCD and canvases are real RGB565 frame buffers so drawing costs and pixel traffic are
+// representative. Text uses the glyph tables of Adafruit style fonts (e.g. the DSEG7 fonts in
+// include/); the built-in FreeSans fonts are stand-ins with the correct line height only.
+//
+
+#include <time.h>
+
+#include <vector>
+
+#include "Arduino.h"
+
+// RGB565 colours, same values as LovyanGFX
+static constexpr uint32_t TFT_BLACK = 0x0000;
+static constexpr uint32_t TFT_NAVY = 0x000F;
+static constexpr uint32_t TFT_DARKGREEN = 0x03E0;
+static constexpr uint32_t TFT_DARKCYAN = 0x03EF;
+static constexpr uint32_t TFT_MAROON = 0x7800;
+static constexpr uint32_t TFT_PURPLE = 0x780F;
+static constexpr uint32_t TFT_OLIVE = 0x7BE0;
+static constexpr uint32_t TFT_LIGHTGREY = 0xD69A;
+static constexpr uint32_t TFT_LIGHTGRAY = 0xD69A;
+static constexpr uint32_t TFT_DARKGREY = 0x7BEF;
+static constexpr uint32_t TFT_DARKGRAY = 0x7BEF;
+static constexpr uint32_t TFT_BLUE = 0x001F;
+static constexpr uint32_t TFT_GREEN = 0x07E0;
+static constexpr uint32_t TFT_CYAN = 0x07FF;
+static constexpr uint32_t TFT_RED = 0xF800;
+static constexpr uint32_t TFT_MAGENTA = 0xF81F;
+static constexpr uint32_t TFT_YELLOW = 0xFFE0;
+static constexpr uint32_t TFT_WHITE = 0xFFFF;
+static constexpr uint32_t TFT_ORANGE = 0xFDA0;
+static constexpr uint32_t TFT_GREENYELLOW = 0xB7E0;
+static constexpr uint32_t TFT_PINK = 0xFE19;
+
+// Adafruit GFX font format, used by the fonts in include/
+struct GFXglyph {
+  uint16_t bitmapOffset;
+  uint8_t width;
+  uint8_t height;
+  uint8_t xAdvance;
+  int8_t xOffset;
+  int8_t yOffset;
+};
+
+struct GFXfont {
+  uint8_t *bitmap;
+  GFXglyph *glyph;
+  uint16_t first;
+  uint16_t last;
+  uint8_t yAdvance;
+};
+
+// Built-in fonts, metrics only
+namespace fonts {
+extern const GFXfont Font0;
+extern const GFXfont FreeSans9pt7b;
+extern const GFXfont FreeSans12pt7b;
+extern const GFXfont FreeSans18pt7b;
+extern const GFXfont FreeSans24pt7b;
+extern const GFXfont FreeSansBold12pt7b;
+extern const GFXfont FreeSansBold24pt7b;
+}  // namespace fonts
+using namespace fonts;
+
+enum textdatum_t : uint8_t {
+  top_left = 0,
+  top_center = 1,
+  top_centre = 1,
+  top_right = 2,
+  middle_left = 4,
+  middle_center = 5,
+  middle_centre = 5,
+  middle_right = 6,
+  bottom_left = 8,
+  bottom_center = 9,
+  bottom_centre = 9,
+  bottom_right = 10,
+};
+
+/*
+-----------------
+  RGB565 frame buffer with the LovyanGFX drawing calls used by the firmware
+-----------------
+*/
+class NativeGFX {
+ public:
+  NativeGFX(int32_t w = 0, int32_t h = 0);
+
+  int32_t width(void) const { return _width; }
+  int32_t height(void) const { return _height; }
+  uint16_t *buffer(void) { return _fb.data(); }
+  uint16_t readPixel(int32_t x, int32_t y) const;
+  uint32_t pixelsWritten(void) const { return _pixels_written; }
+
+  void drawPixel(int32_t x, int32_t y, uint32_t colour);
+  void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t colour);
+  void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t colour);
+  void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t colour);
+  void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t colour);
+  void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t colour);
+  void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t colour);
+  void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t colour);
+  void fillArc(int32_t x, int32_t y, int32_t r0, int32_t r1, float angle0, float angle1, uint32_t colour);
+  void drawArc(int32_t x, int32_t y, int32_t r0, int32_t r1, float angle0, float angle1, uint32_t colour);
+  void fillScreen(uint32_t colour) { fillRect(0, 0, _width, _height, colour); }
+  void clear(uint32_t colour = TFT_BLACK) { fillScreen(colour); }
+
+  // Drawing outside the clip rectangle is discarded
+  void setClipRect(int32_t x, int32_t y, int32_t w, int32_t h);
+  void clearClipRect(void) { setClipRect(0, 0, _width, _height); }
+  void getClipRect(int32_t *x, int32_t *y, int32_t *w, int32_t *h) const {
+    *x = _clip_x0;
+    *y = _clip_y0;
+    *w = _clip_x1 - _clip_x0;
+    *h = _clip_y1 - _clip_y0;
+  }
+
+  // scroll() moves the pixels inside the scroll rectangle, the vacated area is filled with black
+  void setScrollRect(int32_t x, int32_t y, int32_t w, int32_t h);
+  void clearScrollRect(void) { setScrollRect(0, 0, _width, _height); }
+  void scroll(int32_t dx, int32_t dy);
+
+  // RGB565 image, copied straight away as there is no DMA on the host
+  void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+  void waitDMA(void) {}
+
+  void setFont(const GFXfont *font) { _font = font; }
+  void setTextColor(uint32_t fg) {
+    _text_fg = fg;
+    _text_bg_set = false;
+  }
+  void setTextColor(uint32_t fg, uint32_t bg) {
+    _text_fg = fg;
+    _text_bg = bg;
+    _text_bg_set = true;
+  }
+  void setTextDatum(uint8_t datum) { _datum = datum; }
+  void setTextPadding(uint32_t padding) { _padding = padding; }
+  void setCursor(int32_t x, int32_t y) {
+    _cursor_x = x;
+    _cursor_y = y;
+  }
+  size_t print(const char *str);
+  size_t drawString(const char *str, int32_t x, int32_t y);
+  int32_t textWidth(const char *str) const;
+  int32_t fontHeight(void) const { return _font->yAdvance; }
+
+ protected:
+  void resize(int32_t w, int32_t h);
+  int32_t drawChar(char c, int32_t x, int32_t y);
+
+  int32_t _width;
+  int32_t _height;
+  std::vector<uint16_t> _fb;
+  uint32_t _pixels_written = 0;
+  int32_t _clip_x0 = 0, _clip_y0 = 0, _clip_x1 = 0, _clip_y1 = 0;
+  int32_t _scroll_x = 0, _scroll_y = 0, _scroll_w = 0, _scroll_h = 0;
+  const GFXfont *_font;
+  uint32_t _text_fg = TFT_WHITE;
+  uint32_t _text_bg = TFT_BLACK;
+  bool _text_bg_set = false;
+  uint8_t _datum = top_left;
+  uint32_t _padding = 0;
+  int32_t _cursor_x = 0;
+  int32_t _cursor_y = 0;
+};
+
+// Common base of the LCD and sprites, so drawing code can target either
+typedef NativeGFX LovyanGFX;
+
+/*
+-----------------
+  Core2 320x240 ILI9342C LCD
+-----------------
+*/
+class M5GFX : public NativeGFX {
+ public:
+  M5GFX(void) : NativeGFX(320, 240) {}
+  void setBrightness(uint8_t brightness) { _brightness = brightness; }
+  uint8_t getBrightness(void) const { return _brightness; }
+  void startWrite(void) {}
+  void endWrite(void) {}
+
+ private:
+  uint8_t _brightness = 0;
+};
+
+/*
+-----------------
+  Off-screen sprite (LGFX_Sprite)
+-----------------
+*/
+class M5Canvas : public NativeGFX {
+ public:
+  M5Canvas(NativeGFX *parent = nullptr) : _parent(parent) {}
+  void setPsram(bool enabled) { (void)enabled; }  // Host memory, there is no PSRAM to choose
+  void *createSprite(int32_t w, int32_t h);
+  void *getBuffer(void) { return _fb.data(); }
+  void deleteSprite(void) { resize(0, 0); }
+  void fillSprite(uint32_t colour) { fillScreen(colour); }
+  void setPivot(float x, float y) {
+    _pivot_x = x;
+    _pivot_y = y;
+  }
+  void pushSprite(int32_t x, int32_t y) { pushSprite(_parent, x, y); }
+  void pushSprite(NativeGFX *dst, int32_t x, int32_t y);
+  void pushRotateZoom(float x, float y, float angle, float zoom_x, float zoom_y) { rotate_zoom(_parent, x, y, angle, zoom_x, zoom_y, false, 0); }
+  void pushRotateZoom(NativeGFX *dst, float x, float y, float angle, float zoom_x, float zoom_y) { rotate_zoom(dst, x, y, angle, zoom_x, zoom_y, false, 0); }
+  // Pixels of colour transp are not drawn
+  void pushRotateZoom(float x, float y, float angle, float zoom_x, float zoom_y, uint32_t transp) { rotate_zoom(_parent, x, y, angle, zoom_x, zoom_y, true, transp); }
+  void pushRotateZoom(NativeGFX *dst, float x, float y, float angle, float zoom_x, float zoom_y, uint32_t transp) { rotate_zoom(dst, x, y, angle, zoom_x, zoom_y, true, transp); }
+
+ private:
+  void rotate_zoom(NativeGFX *dst, float x, float y, float angle, float zoom_x, float zoom_y, bool use_transp, uint32_t transp);
+
+  NativeGFX *_parent;
+  float _pivot_x = 0;
+  float _pivot_y = 0;
+};
+
+namespace m5 {
+
+struct rtc_time_t {
+  int8_t hours;
+  int8_t minutes;
+  int8_t seconds;
+};
+
+struct rtc_date_t {
+  int8_t weekDay;
+  int8_t month;
+  int8_t date;
+  int16_t year;
+};
+
+struct rtc_datetime_t {
+  rtc_date_t date;
+  rtc_time_t time;
+};
+
+// RTC chip stand-in, runs from the firmware clock so accelerated time also moves the RTC
+class RTC_Class {
+ public:
+  rtc_datetime_t getDateTime(void);
+  bool getTime(rtc_time_t *time);
+  bool getDate(rtc_date_t *date);
+  void setDateTime(const tm *datetime);
+
+ private:
+  time_t now(void);
+  int64_t _offset_s = 0;
+};
+
+class Button_Class {
+ public:
+  bool isPressed(void) const { return _press; }
+  bool wasPressed(void) const { return _press && !_last_press; }
+  bool wasReleased(void) const { return !_press && _last_press; }
+  bool wasClicked(void) const { return wasReleased() && _last_hold_ms < _hold_thresh_ms; }
+  bool isHolding(void) const { return _press && _hold_ms >= _hold_thresh_ms; }
+  bool pressedFor(uint32_t ms) const { return _press && _hold_ms >= ms; }
+  void setRawState(uint32_t msec, bool press);
+
+ private:
+  bool _press = false;
+  bool _last_press = false;
+  uint32_t _press_start = 0;
+  uint32_t _hold_ms = 0;
+  uint32_t _last_hold_ms = 0;
+  uint32_t _hold_thresh_ms = 500;
+};
+
+struct touch_detail_t {
+  int16_t x = -1;
+  int16_t y = -1;
+  bool pressed = false;
+  bool wasPressed(void) const { return pressed; }
+  bool wasClicked(void) const { return pressed; }
+  bool isPressed(void) const { return pressed; }
+};
+
+class Touch_Class {
+ public:
+  touch_detail_t getDetail(size_t index = 0) const {
+    (void)index;
+    return _detail;
+  }
+  void update(void);
+
+ private:
+  touch_detail_t _detail;
+};
+
+class AXP192_Class {
+ public:
+  float getBatteryVoltage(void) const { return 4.0f; }
+};
+
+class Power_Class {
+ public:
+  int32_t getBatteryLevel(void) const { return 80; }
+  bool isCharging(void) const { return false; }
+  AXP192_Class Axp192;
+};
+
+class Speaker_Class {
+ public:
+  bool begin(void) { return true; }
+  void setVolume(uint8_t volume) { _volume = volume; }
+  bool tone(float frequency, uint32_t duration = UINT32_MAX, int channel = -1, bool stop_current_sound = true) {
+    (void)frequency;
+    (void)duration;
+    (void)channel;
+    (void)stop_current_sound;
+    return true;
+  }
+
+ private:
+  uint8_t _volume = 0;
+};
+
+struct config_t {
+  uint32_t serial_baudrate = 115200;
+  bool clear_display = true;
+  bool output_power = true;
+  bool internal_imu = true;
+  bool internal_rtc = true;
+  bool external_imu = false;
+  bool external_rtc = false;
+  uint8_t led_brightness = 0;
+};
+
+class M5Unified {
+ public:
+  config_t config(void) const { return config_t(); }
+  void begin(config_t cfg);
+  void update(void);
+
+  M5GFX Lcd;
+  M5GFX &Display = Lcd;
+  Button_Class BtnA;
+  Button_Class BtnB;
+  Button_Class BtnC;
+  Touch_Class Touch;
+  RTC_Class Rtc;
+  Power_Class Power;
+  Speaker_Class Speaker;
+};
+
+}  // namespace m5
+
+extern m5::M5Unified M5;
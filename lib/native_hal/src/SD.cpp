@@ -0,0 +1,103 @@
+//
+//    FILE: SD.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the ESP32 SD card library and fs::FS, backed by a host directory
+//
+
+#include "SD.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hal_native.h"
+
+SPIClass SPI;
+SDFS SD;
+
+namespace fs {
+
+/////////////////////////////////////////////////////
+//
+// FILE
+//
+File::File(FILE *fp) : _fp(fp, fclose) {
+}
+
+size_t File::write(const uint8_t *buf, size_t size) {
+  if (!_fp) return 0;
+  size_t written = fwrite(buf, 1, size, _fp.get());
+  hal_native::sd_count_write(written);
+  return written;
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+  return _fp ? fread(buf, 1, size, _fp.get()) : 0;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  const int whence[] = {SEEK_SET, SEEK_CUR, SEEK_END};
+  return _fp && fseek(_fp.get(), pos, whence[mode]) == 0;
+}
+
+size_t File::position(void) const {
+  return _fp ? ftell(_fp.get()) : 0;
+}
+
+size_t File::size(void) const {
+  if (!_fp) return 0;
+  struct stat st;
+  fflush(_fp.get());
+  return fstat(fileno(_fp.get()), &st) == 0 ? st.st_size : 0;
+}
+
+void File::flush(void) {
+  if (_fp) fflush(_fp.get());
+}
+
+/////////////////////////////////////////////////////
+//
+// FILE SYSTEM
+//
+bool FS::mount(const char *host_dir) {
+  ::mkdir(host_dir, 0755);
+  struct stat st;
+  if (stat(host_dir, &st) != 0 || !S_ISDIR(st.st_mode)) return false;
+  _root = host_dir;
+  return true;
+}
+
+File FS::open(const char *path, const char *mode, const bool create) {
+  (void)create;
+  if (_root.empty()) return File();
+  // Open mode is passed straight to fopen(), the same as the ESP32 VFS
+  FILE *fp = fopen(host_path(path).c_str(), mode);
+  return fp ? File(fp) : File();
+}
+
+bool FS::exists(const char *path) {
+  struct stat st;
+  return !_root.empty() && stat(host_path(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char *path) {
+  return !_root.empty() && unlink(host_path(path).c_str()) == 0;
+}
+
+bool FS::mkdir(const char *path) {
+  return !_root.empty() && ::mkdir(host_path(path).c_str(), 0755) == 0;
+}
+
+}  // namespace fs
+
+bool SDFS::begin(uint8_t ssPin, SPIClass &spi, uint32_t frequency, const char *mountpoint, uint8_t max_files, bool format_if_empty) {
+  (void)ssPin;
+  (void)spi;
+  (void)frequency;
+  (void)mountpoint;
+  (void)max_files;
+  (void)format_if_empty;
+  if (!hal_native::sd_present()) return false;
+  return mount(hal_native::sd_dir());
+}
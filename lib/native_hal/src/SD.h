@@ -0,0 +1,30 @@
+#pragma once
+//
+//    FILE: SD.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the ESP32 SD card library
+//
+// The card is a host directory, NATIVE_SD_DIR (default ./sd_card, created if missing).
+// NATIVE_NO_SD=1 behaves as if no card is inserted.
+//
+
+#include "FS.h"
+#include "SPI.h"
+
+enum sdcard_type_t { CARD_NONE,
+                     CARD_MMC,
+                     CARD_SD,
+                     CARD_SDHC,
+                     CARD_UNKNOWN };
+
+class SDFS : public fs::FS {
+ public:
+  bool begin(uint8_t ssPin = 4, SPIClass &spi = SPI, uint32_t frequency = 4000000, const char *mountpoint = "/sd",
+             uint8_t max_files = 5, bool format_if_empty = false);
+  void end(void) { unmount(); }
+  sdcard_type_t cardType(void) const { return _root.empty() ? CARD_NONE : CARD_SDHC; }
+};
+
+extern SDFS SD;
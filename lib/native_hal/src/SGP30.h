@@ -0,0 +1,53 @@
+#pragma once
+//
+//    FILE: SGP30.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: Linux stand-in for the robtillaart SGP30 library, models an SGP-30 on the I2C bus
+//
+// Only the calls the firmware makes. The sensor is on the bus when NATIVE_SGP30_PORT says so. Its
+// eCO2 follows the room (hal_native::room_air()) but over-reads the rise above outdoor air and is
+// noisier than the NDIR sensors, as a metal oxide sensor does. A measurement can be read 12 ms
+// after it is requested. Without it every command fails as a NACK would.
+//
+
+#include <math.h>
+
+#include "Wire.h"
+#include "hal_native_internal.h"
+
+#define sgp30_native_addr       0x58
+#define sgp30_native_measure_ms 12  // measure_iaq execution time
+
+class SGP30 {
+ public:
+  SGP30(TwoWire *wire = &Wire) : _wire(wire) {}
+  bool begin(uint8_t dataPin, uint8_t clockPin) {
+    _wire->begin(dataPin, clockPin);
+    return transfer();
+  }
+  void request(void) {
+    if (transfer()) _request_ms = millis();
+  }
+  bool read(void) {
+    if (!transfer() || millis() - _request_ms < sgp30_native_measure_ms) return false;
+    float co2, temperature, humidity;
+    float t = millis() / 1000.0f;
+    hal_native::room_air(t, co2, temperature, humidity);
+    _co2 = (uint16_t)(400.0f + 1.15f * (co2 - 400.0f) + 30.0f * sinf(t * 2.1f) + 20.0f * sinf(t * 0.37f));
+    return true;
+  }
+  uint16_t getCO2(void) { return _co2; }
+
+ private:
+  bool transfer(void) {
+    bool ok = _wire->started() && hal_native::i2c_ack(_wire->sda(), _wire->scl(), sgp30_native_addr);
+    hal_native::i2c_count(ok);
+    return ok;
+  }
+
+  TwoWire *_wire;
+  uint32_t _request_ms = 0;
+  uint16_t _co2 = 0;
+};
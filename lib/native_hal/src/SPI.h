@@ -0,0 +1,23 @@
+#pragma once
+//
+//    FILE: SPI.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the ESP32 SPI bus, only enough for SD.begin()
+//
+
+#include "Arduino.h"
+
+class SPIClass {
+ public:
+  void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {
+    (void)sck;
+    (void)miso;
+    (void)mosi;
+    (void)ss;
+  }
+  void end(void) {}
+};
+
+extern SPIClass SPI;
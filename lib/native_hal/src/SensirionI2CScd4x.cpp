@@ -0,0 +1,196 @@
+//
+//    FILE: SensirionI2CScd4x.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the Sensirion SCD-4x driver
+//
+
+#include "SensirionI2CScd4x.h"
+
+#include "hal_native_internal.h"
+
+#define scd4x_error_nack 0x0101  // Same value the Sensirion driver uses for a NACK'd write
+
+void SensirionI2CScd4x::begin(TwoWire &i2cBus) {
+  _wire = &i2cBus;
+  hal_native::i2c_device(0x62, command, read, this);
+}
+
+// Sensirion CRC-8, polynomial 0x31, initial value 0xFF
+uint8_t SensirionI2CScd4x::crc(const uint8_t *data, size_t len) {
+  uint8_t crc = 0xFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+  }
+  return crc;
+}
+
+// The sensor doesn't answer for a raw command's execution time
+void SensirionI2CScd4x::wait(uint32_t ms) {
+  _busy_ms = millis();
+  _busy_for_ms = ms;
+}
+
+// Raw commands written through Wire: measure_single_shot (0x219D), stop_periodic_measurement
+// (0x3F86), perform_factory_reset (0x3632) and perform_forced_recalibration (0x362F, one argument)
+bool SensirionI2CScd4x::command(void *device, const uint8_t *data, size_t len) {
+  SensirionI2CScd4x &scd = *static_cast<SensirionI2CScd4x *>(device);
+  if (len < 2 || scd.busy()) return false;
+  uint16_t cmd = (uint16_t)(data[0] << 8 | data[1]);
+  if (cmd == 0x3F86 && len == 2) {
+    scd._measuring = false;
+    scd.wait(500);
+    return true;
+  }
+  if (scd._measuring) return false;  // The rest only from idle
+  if (cmd == 0x219D && len == 2) {
+    scd._shot = true;
+    scd._shot_ms = millis();
+    return true;
+  }
+  if (cmd == 0x3632 && len == 2) {
+    scd.factory_defaults();
+    scd.wait(1200);
+    return true;
+  }
+  if (cmd == 0x362F && len == 5 && crc(data + 2, 2) == data[4]) {
+    scd._frc_word = scd.frc((uint16_t)(data[2] << 8 | data[3]));
+    scd._frc_ready = true;
+    scd.wait(400);
+    return true;
+  }
+  return false;
+}
+
+// Only the forced recalibration answers a read, once, after its execution time
+size_t SensirionI2CScd4x::read(void *device, uint8_t *data, size_t len) {
+  SensirionI2CScd4x &scd = *static_cast<SensirionI2CScd4x *>(device);
+  if (len < 3 || scd.busy() || !scd._frc_ready) return 0;
+  scd._frc_ready = false;
+  data[0] = (uint8_t)(scd._frc_word >> 8);
+  data[1] = (uint8_t)(scd._frc_word & 0xFF);
+  data[2] = crc(data, 2);
+  return 3;
+}
+
+// One command on the bus, fails if no sensor is attached or the command is not allowed right now
+bool SensirionI2CScd4x::transfer(bool allowed_while_measuring) {
+  bool ok = _wire != nullptr && _wire->started() && hal_native::i2c_ack(_wire->sda(), _wire->scl(), 0x62) &&
+            !busy() && (allowed_while_measuring || !_measuring);
+  hal_native::i2c_count(ok);
+  return ok;
+}
+
+uint32_t SensirionI2CScd4x::available_samples(void) const {
+  return _measuring ? (millis() - _start_ms) / _period_ms : 0;
+}
+
+uint16_t SensirionI2CScd4x::startPeriodicMeasurement(void) {
+  if (!transfer(false)) return scd4x_error_nack;
+  _measuring = true;
+  _start_ms = millis();
+  _period_ms = 5000;
+  _samples_read = 0;
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::startLowPowerPeriodicMeasurement(void) {
+  if (startPeriodicMeasurement()) return scd4x_error_nack;
+  _period_ms = 30000;
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::stopPeriodicMeasurement(void) {
+  if (!transfer(true)) return scd4x_error_nack;
+  _measuring = false;
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::getDataReadyStatus(uint16_t &dataReady) {
+  if (!transfer(true)) return scd4x_error_nack;
+  dataReady = (_shot || available_samples() > _samples_read) ? 0x8006 : 0x8000;
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::readMeasurement(uint16_t &co2, float &temperature, float &humidity) {
+  if (!transfer(true)) return scd4x_error_nack;
+  uint32_t samples = available_samples();
+  if (!_shot && samples <= _samples_read) return scd4x_error_nack;  // No new data, the sensor NACKs the read
+  _samples_read = samples;
+  _shot = false;
+
+  float room_co2;
+  hal_native::room_air(millis() / 1000.0f, room_co2, temperature, humidity);
+  co2 = (uint16_t)(room_co2 - _frc_offset);
+  temperature -= _t_offset - 4.0f;
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::setTemperatureOffset(float tOffset) {
+  if (!transfer(false)) return scd4x_error_nack;
+  _t_offset = tOffset;
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::getTemperatureOffset(float &tOffset) {
+  if (!transfer(false)) return scd4x_error_nack;
+  tOffset = _t_offset;
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::setSensorAltitude(uint16_t sensorAltitude) {
+  if (!transfer(false)) return scd4x_error_nack;
+  _altitude = sensorAltitude;
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::getSensorAltitude(uint16_t &sensorAltitude) {
+  if (!transfer(false)) return scd4x_error_nack;
+  sensorAltitude = _altitude;
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::setAutomaticSelfCalibration(uint16_t ascEnabled) {
+  if (!transfer(false)) return scd4x_error_nack;
+  _asc = ascEnabled;
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::getAutomaticSelfCalibration(uint16_t &ascEnabled) {
+  if (!transfer(false)) return scd4x_error_nack;
+  ascEnabled = _asc;
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::persistSettings(void) {
+  return transfer(false) ? 0 : scd4x_error_nack;
+}
+
+uint16_t SensirionI2CScd4x::performForcedRecalibration(uint16_t targetCo2Concentration, uint16_t &frcCorrection) {
+  if (!transfer(false)) return scd4x_error_nack;
+  frcCorrection = frc(targetCo2Concentration);
+  return 0;
+}
+
+uint16_t SensirionI2CScd4x::performFactoryReset(void) {
+  if (!transfer(false)) return scd4x_error_nack;
+  factory_defaults();
+  return 0;
+}
+
+// The FRC correction as the sensor returns it, offset by 0x8000
+uint16_t SensirionI2CScd4x::frc(uint16_t target) {
+  (void)target;
+  const int16_t correction = -30;  // Pretend the sensor currently reads 30 ppm high
+  _frc_offset = -correction;
+  return (uint16_t)(correction + 0x8000);
+}
+
+void SensirionI2CScd4x::factory_defaults(void) {
+  _t_offset = 4.0f;
+  _altitude = 0;
+  _asc = 1;
+  _frc_offset = 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+//
+//    FILE: SensirionI2CScd4x.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the Sensirion SCD-4x driver, models an SCD-41 on the I2C bus
+//
+// The model produces a new measurement every 5 s after startPeriodicMeasurement() (30 s after
+// startLowPowerPeriodicMeasurement(), or once 5 s after a measure_single_shot command written
+// through Wire, which the library would wait out), follows a slow deterministic
+// CO2/temperature/humidity waveform, and rejects commands the real sensor NACKs while measuring.
+// Nothing answers while a single shot is measuring, nor for the execution time of a stop, factory
+// reset or forced recalibration written through Wire (the library's own calls wait it out). Every command is counted as an I2C transaction (see hal_native::i2c_stats()).
+// All methods return 0 on success, as the Sensirion driver does.
+//
+
+#include "Wire.h"
+
+class SensirionI2CScd4x {
+ public:
+  void begin(TwoWire &i2cBus);
+
+  uint16_t startPeriodicMeasurement(void);
+  uint16_t startLowPowerPeriodicMeasurement(void);
+  uint16_t stopPeriodicMeasurement(void);
+  uint16_t getDataReadyStatus(uint16_t &dataReady);
+  uint16_t readMeasurement(uint16_t &co2, float &temperature, float &humidity);
+
+  uint16_t setTemperatureOffset(float tOffset);
+  uint16_t getTemperatureOffset(float &tOffset);
+  uint16_t setSensorAltitude(uint16_t sensorAltitude);
+  uint16_t getSensorAltitude(uint16_t &sensorAltitude);
+  uint16_t setAutomaticSelfCalibration(uint16_t ascEnabled);
+  uint16_t getAutomaticSelfCalibration(uint16_t &ascEnabled);
+  uint16_t persistSettings(void);
+  uint16_t performForcedRecalibration(uint16_t targetCo2Concentration, uint16_t &frcCorrection);
+  uint16_t performFactoryReset(void);
+
+ private:
+  bool transfer(bool allowed_while_measuring);
+  uint32_t available_samples(void) const;
+  bool shot_running(void) const { return _shot && millis() - _shot_ms < 5000; }
+  bool busy(void) const { return shot_running() || millis() - _busy_ms < _busy_for_ms; }
+  void wait(uint32_t ms);
+  uint16_t frc(uint16_t target);
+  void factory_defaults(void);
+  static bool command(void *device, const uint8_t *data, size_t len);
+  static size_t read(void *device, uint8_t *data, size_t len);
+  static uint8_t crc(const uint8_t *data, size_t len);
+
+  TwoWire *_wire = nullptr;
+  bool _measuring = false;
+  uint32_t _start_ms = 0;
+  uint32_t _period_ms = 5000;
+  uint32_t _samples_read = 0;
+  bool _shot = false;  // Single shot measuring or ready, until it is read
+  uint32_t _shot_ms = 0;
+  float _t_offset = 4.0f;
+  uint16_t _altitude = 0;
+  uint16_t _asc = 1;
+  int16_t _frc_offset = 0;
+  uint32_t _busy_ms = 0;  // Executing a raw command, from _busy_ms for _busy_for_ms
+  uint32_t _busy_for_ms = 0;
+  bool _frc_ready = false;  // FRC correction waiting to be read through Wire
+  uint16_t _frc_word = 0;
+};
@@ -0,0 +1,94 @@
+#pragma once
+//
+//    FILE: SparkFun_SCD30_Arduino_Library.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: Linux stand-in for the SparkFun SCD-30 library, models an SCD-30 on the I2C bus
+//
+// Only the calls the firmware makes. The sensor is on the bus when NATIVE_SCD30_PORT says so, it
+// measures the same room as the SCD-41 model (hal_native::room_air()) every 2 s, reading a little
+// high with its own noise, so the two can be fused and compared. Without it every command fails
+// as a NACK would and the sensor probe never picks it.
+//
+
+#include <math.h>
+
+#include "Wire.h"
+#include "hal_native_internal.h"
+
+#define scd30_native_addr   0x61
+#define scd30_native_period 2000  // ms, continuous measurement interval
+
+class SCD30 {
+ public:
+  bool begin(TwoWire &wirePort = Wire, bool autoCalibrate = false, bool measBegin = true) {
+    _wire = &wirePort;
+    _asc = autoCalibrate;
+    if (!transfer()) return false;
+    _measuring = measBegin;
+    _start_ms = millis();
+    _samples_read = 0;
+    return true;
+  }
+  // Reading a sample clears the ready flag, as on the real sensor
+  bool dataAvailable(void) { return transfer() && available_samples() > _samples_read; }
+  uint16_t getCO2(void) {
+    if (!transfer()) return 0;
+    _samples_read = available_samples();
+    float co2, temperature, humidity;
+    float t = millis() / 1000.0f;
+    hal_native::room_air(t, co2, temperature, humidity);
+    _temperature = temperature - (_t_offset - 2.0f);
+    _humidity = humidity + 1.5f;
+    return (uint16_t)(co2 + 12.0f + 10.0f * sinf(t * 1.3f) - _frc_offset);
+  }
+  float getTemperature(void) { return _temperature; }
+  float getHumidity(void) { return _humidity; }
+
+  bool setForcedRecalibrationFactor(uint16_t concentration) {
+    if (!transfer()) return false;
+    _frc = concentration;
+    _frc_offset = 12.0f;  // The reading's bias is what a recalibration in fresh air removes
+    return true;
+  }
+  bool getForcedRecalibration(uint16_t *val) {
+    *val = _frc;
+    return transfer();
+  }
+  bool setTemperatureOffset(float tempOffset) {
+    _t_offset = tempOffset;
+    return transfer();
+  }
+  float getTemperatureOffset(void) { return transfer() ? _t_offset : 0; }
+  bool setAltitudeCompensation(uint16_t altitude) {
+    _altitude = altitude;
+    return transfer();
+  }
+  uint16_t getAltitudeCompensation(void) { return transfer() ? _altitude : 0; }
+  bool setAutoSelfCalibration(bool enable) {
+    _asc = enable;
+    return transfer();
+  }
+  bool getAutoSelfCalibration(void) { return transfer() && _asc; }
+
+ private:
+  bool transfer(void) {
+    bool ok = _wire != nullptr && _wire->started() && hal_native::i2c_ack(_wire->sda(), _wire->scl(), scd30_native_addr);
+    hal_native::i2c_count(ok);
+    return ok;
+  }
+  uint32_t available_samples(void) const { return _measuring ? (millis() - _start_ms) / scd30_native_period : 0; }
+
+  TwoWire *_wire = nullptr;
+  bool _measuring = false;
+  uint32_t _start_ms = 0;
+  uint32_t _samples_read = 0;
+  float _temperature = 0;
+  float _humidity = 0;
+  float _t_offset = 2.0f;
+  float _frc_offset = 0;
+  uint16_t _frc = 0;
+  uint16_t _altitude = 0;
+  bool _asc = false;
+};
@@ -0,0 +1,73 @@
+//
+//    FILE: WiFi.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the ESP32 WiFi station and SNTP client
+//
+
+#include "WiFi.h"
+
+#include "esp_sntp.h"
+
+#define wifi_connect_ms 1500
+#define sntp_sync_ms    2000
+
+WiFiClass WiFi;
+
+static bool sntp_started = false;
+static uint32_t sntp_start_ms = 0;
+
+static bool ap_in_range(void) {
+  const char *val = getenv("NATIVE_NO_WIFI");
+  return !(val != nullptr && atoi(val) == 1);
+}
+
+static bool ntp_answers(void) {
+  const char *val = getenv("NATIVE_NO_NTP");
+  return !(val != nullptr && atoi(val) == 1);
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *passphrase) {
+  (void)ssid;
+  (void)passphrase;
+  _started = true;
+  _begin_ms = millis();
+  return WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::status(void) {
+  if (!_started) return WL_IDLE_STATUS;
+  if (!ap_in_range()) return WL_NO_SSID_AVAIL;
+  return (millis() - _begin_ms >= wifi_connect_ms) ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifioff, bool eraseap) {
+  (void)wifioff;
+  (void)eraseap;
+  _started = false;
+  sntp_started = false;
+  return true;
+}
+
+bool WiFiClass::mode(wifi_mode_t m) {
+  if (m == WIFI_OFF) _started = false;
+  return true;
+}
+
+void configTzTime(const char *tz, const char *server1, const char *server2, const char *server3) {
+  (void)server1;
+  (void)server2;
+  (void)server3;
+  setenv("TZ", tz, 1);
+  tzset();
+  sntp_started = true;
+  sntp_start_ms = millis();
+}
+
+sntp_sync_status_t sntp_get_sync_status(void) {
+  if (!sntp_started || WiFi.status() != WL_CONNECTED || !ntp_answers()) return SNTP_SYNC_STATUS_RESET;
+  if (millis() - sntp_start_ms < sntp_sync_ms) return SNTP_SYNC_STATUS_RESET;
+  sntp_started = false;  // Like ESP-IDF, COMPLETED is only reported once per sync
+  return SNTP_SYNC_STATUS_COMPLETED;
+}
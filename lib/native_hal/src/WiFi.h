@@ -0,0 +1,42 @@
+#pragma once
+//
+//    FILE: WiFi.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the ESP32 WiFi station API
+//
+// The access point "answers" 1.5 s after begin(). Set NATIVE_NO_WIFI=1 to simulate
+// an access point that is out of range, or NATIVE_NO_NTP=1 for an NTP server that never answers.
+//
+
+#include "Arduino.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED = 6,
+} wl_status_t;
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+  WIFI_AP = 2,
+  WIFI_AP_STA = 3,
+} wifi_mode_t;
+
+class WiFiClass {
+ public:
+  wl_status_t begin(const char *ssid, const char *passphrase = nullptr);
+  wl_status_t status(void);
+  bool disconnect(bool wifioff = false, bool eraseap = false);
+  bool mode(wifi_mode_t m);
+
+ private:
+  bool _started = false;
+  uint32_t _begin_ms = 0;
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,31 @@
+//
+//    FILE: Wire.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the ESP32 TwoWire I2C driver
+//
+
+#include "Wire.h"
+
+#include "hal_native_internal.h"
+
+TwoWire Wire;
+TwoWire Wire1;
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  (void)sendStop;
+  bool ack = _started && hal_native::i2c_ack(_sda, _scl, _address);
+  bool data_ack = ack && (_tx_len == 0 || hal_native::i2c_command(_address, _tx, _tx_len));
+  hal_native::i2c_count(data_ack);
+  return !ack ? 2 : !data_ack ? 3 : 0;
+}
+
+uint8_t TwoWire::requestFrom(uint16_t address, uint8_t size, bool sendStop) {
+  (void)sendStop;
+  bool ack = _started && hal_native::i2c_ack(_sda, _scl, address);
+  _rx_pos = 0;
+  _rx_len = ack ? hal_native::i2c_read(address, _rx, size < sizeof(_rx) ? size : sizeof(_rx)) : 0;
+  hal_native::i2c_count(_rx_len > 0);
+  return (uint8_t)_rx_len;
+}
@@ -0,0 +1,67 @@
+#pragma once
+//
+//    FILE: Wire.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the ESP32 TwoWire I2C driver
+//
+// Devices on the simulated bus (see SensirionI2CScd4x.h) report each transfer through
+// hal_native::i2c_count() so bus occupancy can be measured on a desktop. An empty write
+// (beginTransmission() then endTransmission()) probes an address, as an I2C scanner does. Bytes
+// written between them are a command, passed to the device model at that address, which also
+// answers requestFrom() (see hal_native::i2c_device()).
+//
+
+#include "Arduino.h"
+
+class TwoWire {
+ public:
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+    (void)frequency;
+    _sda = sda;
+    _scl = scl;
+    _started = true;
+    hal_native::i2c_count_reset();
+    return true;
+  }
+  bool end(void) {
+    _started = false;
+    return true;
+  }
+  bool setClock(uint32_t frequency) {
+    (void)frequency;
+    return true;
+  }
+  bool started(void) const { return _started; }
+  int sda(void) const { return _sda; }
+  int scl(void) const { return _scl; }
+
+  void beginTransmission(uint16_t address) {
+    _address = address;
+    _tx_len = 0;
+  }
+  size_t write(uint8_t data) {
+    if (_tx_len == sizeof(_tx)) return 0;
+    _tx[_tx_len++] = data;
+    return 1;
+  }
+  uint8_t endTransmission(bool sendStop = true);  // 0 = ACK, 2 = address NACK, 3 = data NACK, as the ESP32 driver
+  uint8_t requestFrom(uint16_t address, uint8_t size, bool sendStop = true);  // Bytes read, 0 on a NACK
+  int available(void) { return (int)(_rx_len - _rx_pos); }
+  int read(void) { return _rx_pos < _rx_len ? _rx[_rx_pos++] : -1; }
+
+ private:
+  uint16_t _address = 0;
+  uint8_t _tx[32];  // The ESP32 driver's buffer size
+  size_t _tx_len = 0;
+  uint8_t _rx[32];
+  size_t _rx_len = 0;
+  size_t _rx_pos = 0;
+  int _sda = -1;
+  int _scl = -1;
+  bool _started = false;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
@@ -0,0 +1,18 @@
+#pragma once
+//
+//    FILE: esp_sntp.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for the ESP-IDF SNTP client status API
+//
+
+typedef enum {
+  SNTP_SYNC_STATUS_RESET,
+  SNTP_SYNC_STATUS_COMPLETED,
+  SNTP_SYNC_STATUS_IN_PROGRESS,
+} sntp_sync_status_t;
+
+// Completes a couple of seconds after configTzTime() while WiFi is connected, reported once
+// (never with NATIVE_NO_NTP=1)
+sntp_sync_status_t sntp_get_sync_status(void);
@@ -0,0 +1,21 @@
+#pragma once
+//
+//    FILE: task.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Linux stand-in for FreeRTOS tasks, each task is a host thread
+//
+// The core and priority are ignored. vTaskDelay() always sleeps (scaled by NATIVE_TIME_SCALE) so a
+// polling task cannot run the shared firmware clock forward the way delay() does on the loop() thread.
+//
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stack_depth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id);
+void vTaskDelay(TickType_t ticks);
+BaseType_t xPortGetCoreID(void);
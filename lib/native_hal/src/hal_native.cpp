@@ -0,0 +1,225 @@
+//
+//    FILE: hal_native.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Firmware clock, bus statistics and input injection for the Linux hardware abstraction layer
+//
+
+#include "hal_native.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+
+#include "hal_native_internal.h"
+
+namespace hal_native {
+
+static std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+static std::atomic<uint64_t> skipped_us{0};
+static double time_scale = 1.0;
+static bool realtime = false;
+static uint64_t run_us = 0;
+static std::atomic<bool> exit_requested{false};
+static i2c_stats_t i2c = {};
+static bool sensor_attached = true;
+// Where each simulated sensor is wired, pins 0 = not fitted
+struct device_t {
+  uint8_t address;
+  int sda;
+  int scl;
+};
+static device_t devices[] = {
+    {0x62, 32, 33},  // SCD-41, Port-A
+    {0x61, 0, 0},    // SCD-30
+    {0x58, 0, 0},    // SGP-30
+};
+static bool room_flat = false;
+static bool sd_inserted = true;
+static const char *sd_path = "sd_card";
+static sd_stats_t sd = {};
+static int64_t rtc_epoch = 0;
+static uint64_t fault_start_us = 0;
+static uint64_t fault_end_us = 0;
+static pending_input_t input = {};
+
+// Device models taking raw commands, see i2c_device()
+struct command_handler_t {
+  uint8_t address;
+  i2c_command_fn handler;
+  i2c_read_fn reader;
+  void *device;
+};
+static command_handler_t command_handlers[4] = {};
+
+static const char *env(const char *name) {
+  const char *val = getenv(name);
+  return (val != nullptr && *val != '\0') ? val : nullptr;
+}
+
+// "A" = red Port-A, "C" = black Port-C, anything else (or unset) = not fitted
+static void wire_device(device_t &device, const char *port) {
+  char p = port ? port[0] : 0;
+  device.sda = (p == 'A' || p == 'a') ? 32 : (p == 'C' || p == 'c') ? 14 : 0;
+  device.scl = (p == 'A' || p == 'a') ? 33 : (p == 'C' || p == 'c') ? 13 : 0;
+}
+
+void init(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  if (env("NATIVE_RUN_SECONDS")) run_us = (uint64_t)(atof(env("NATIVE_RUN_SECONDS")) * 1e6);
+  if (env("NATIVE_TIME_SCALE")) time_scale = atof(env("NATIVE_TIME_SCALE"));
+  if (time_scale <= 0.0) time_scale = 1.0;
+  realtime = env("NATIVE_REALTIME") && atoi(env("NATIVE_REALTIME")) == 1;
+  sensor_attached = !(env("NATIVE_NO_SENSOR") && atoi(env("NATIVE_NO_SENSOR")) == 1);
+  wire_device(devices[0], env("NATIVE_SENSOR_PORT") ? env("NATIVE_SENSOR_PORT") : "A");
+  wire_device(devices[1], env("NATIVE_SCD30_PORT"));
+  wire_device(devices[2], env("NATIVE_SGP30_PORT"));
+  room_flat = env("NATIVE_ROOM_FLAT") && atoi(env("NATIVE_ROOM_FLAT")) == 1;
+  sd_inserted = !(env("NATIVE_NO_SD") && atoi(env("NATIVE_NO_SD")) == 1);
+  if (env("NATIVE_SD_DIR")) sd_path = env("NATIVE_SD_DIR");
+  rtc_epoch = env("NATIVE_RTC_EPOCH") ? atoll(env("NATIVE_RTC_EPOCH")) : (int64_t)time(nullptr);
+  if (env("NATIVE_SENSOR_FAULT")) {
+    double start_s = 0, duration_s = 0;
+    if (sscanf(env("NATIVE_SENSOR_FAULT"), "%lf:%lf", &start_s, &duration_s) == 2) {
+      fault_start_us = (uint64_t)(start_s * 1e6);
+      fault_end_us = fault_start_us + (uint64_t)(duration_s * 1e6);
+    }
+  }
+  start_time = std::chrono::steady_clock::now();
+}
+
+uint64_t micros64(void) {
+  auto elapsed = std::chrono::steady_clock::now() - start_time;
+  uint64_t real_us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+  return (uint64_t)(real_us * time_scale) + skipped_us.load(std::memory_order_relaxed);
+}
+
+uint64_t host_ns(void) {
+  auto elapsed = std::chrono::steady_clock::now() - start_time;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+void advance_ms(uint32_t ms) {
+  skipped_us.fetch_add((uint64_t)ms * 1000, std::memory_order_relaxed);
+}
+
+void sleep_ms(uint32_t ms) {
+  if (realtime)
+    std::this_thread::sleep_for(std::chrono::microseconds((uint64_t)(ms * 1000 / time_scale)));
+  else
+    advance_ms(ms);
+}
+
+void task_sleep_ms(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::microseconds((uint64_t)(ms * 1000 / time_scale)));
+}
+
+bool should_exit(void) {
+  return exit_requested || (run_us > 0 && micros64() >= run_us);
+}
+
+void request_exit(void) {
+  exit_requested = true;
+}
+
+const i2c_stats_t &i2c_stats(void) {
+  return i2c;
+}
+
+void i2c_count(bool ok) {
+  i2c.transactions++;
+  if (!ok) i2c.errors++;
+}
+
+void i2c_count_reset(void) {
+  i2c.bus_resets++;
+}
+
+const sd_stats_t &sd_stats(void) {
+  return sd;
+}
+
+void sd_count_write(size_t bytes) {
+  sd.writes++;
+  sd.bytes_written += bytes;
+}
+
+bool sensor_present(void) {
+  uint64_t now = micros64();
+  return sensor_attached && !(now >= fault_start_us && now < fault_end_us);
+}
+
+void set_sensor_present(bool present) {
+  sensor_attached = present;
+}
+
+bool i2c_ack(int sda, int scl, uint8_t address) {
+  if (!sensor_present()) return false;
+  for (const device_t &device : devices)
+    if (device.address == address && device.sda == sda && device.scl == scl) return true;
+  return false;
+}
+
+void i2c_device(uint8_t address, i2c_command_fn handler, i2c_read_fn reader, void *device) {
+  for (command_handler_t &h : command_handlers) {
+    if (h.handler && h.address != address) continue;
+    h = {address, handler, reader, device};
+    return;
+  }
+}
+
+// A device without a handler NACKs any command
+bool i2c_command(uint8_t address, const uint8_t *data, size_t len) {
+  for (const command_handler_t &h : command_handlers)
+    if (h.handler && h.address == address) return h.handler(h.device, data, len);
+  return false;
+}
+
+size_t i2c_read(uint8_t address, uint8_t *data, size_t len) {
+  for (const command_handler_t &h : command_handlers)
+    if (h.handler && h.address == address) return h.reader ? h.reader(h.device, data, len) : 0;
+  return 0;
+}
+
+// Slow 10 minute room cycle around 800 ppm, with a little deterministic "noise". Or an empty room,
+// only the noise
+void room_air(float t, float &co2, float &temperature, float &humidity) {
+  co2 = (room_flat ? 800.0f : 800.0f + 350.0f * sinf(2.0f * (float)M_PI * t / 600.0f)) + 15.0f * sinf(t * 0.7f);
+  temperature = 22.0f + 1.5f * sinf(2.0f * (float)M_PI * t / 1800.0f);
+  humidity = 45.0f + 5.0f * sinf(2.0f * (float)M_PI * t / 2400.0f);
+}
+
+bool sd_present(void) {
+  return sd_inserted;
+}
+
+int64_t rtc_boot_epoch(void) {
+  return rtc_epoch;
+}
+
+const char *sd_dir(void) {
+  return sd_path;
+}
+
+void touch_tap(int16_t x, int16_t y) {
+  input.tap = true;
+  input.tap_x = x;
+  input.tap_y = y;
+}
+
+void button_hold(button_t btn, uint32_t hold_ms) {
+  input.hold_until[btn] = (uint32_t)(micros64() / 1000) + hold_ms;
+  input.hold_start[btn] = (uint32_t)(micros64() / 1000);
+}
+
+pending_input_t &pending_input(void) {
+  return input;
+}
+
+}  // namespace hal_native
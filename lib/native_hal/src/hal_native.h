@@ -0,0 +1,77 @@
+#pragma once
+//
+//    FILE: hal_native.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Control surface for the Linux hardware abstraction layer used by [env:native]
+//
+// The stand-in headers in this library (Arduino.h, Wire.h, M5Unified.h, FastLED.h, WiFi.h, ...)
+// let src/main.cpp build unmodified on a desktop. This header is only needed by code that wants
+// to steer the simulated hardware (inject touches/buttons, read bus counters, control the clock).
+//
+// Environment variables read at start-up:
+//   NATIVE_RUN_SECONDS  Stop after this many seconds of firmware time (0 or unset = run forever)
+//   NATIVE_TIME_SCALE   Run millis() this many times faster than wall clock (default 1)
+//   NATIVE_REALTIME     When set to 1, delay() really sleeps. Default: delay() advances the clock instantly
+//   NATIVE_NO_SENSOR    When set to 1, no CO2 sensor answers on the I2C bus (firmware enters simulation mode)
+//   NATIVE_SENSOR_PORT  Where the SCD-41 is plugged in: A = red Port-A, SDA 32/SCL 33 (default),
+//                       C = black Port-C, SDA 14/SCL 13 (fitted inside the battery bottom), N = not fitted
+//   NATIVE_SCD30_PORT   Where an SCD-30 is plugged in, A or C (default: not fitted)
+//   NATIVE_SGP30_PORT   Where an SGP-30 is plugged in, A or C (default: not fitted)
+//   NATIVE_ROOM_FLAT    When set to 1, the room CO2 stays at 800 ppm (plus sensor noise) instead of cycling
+//   NATIVE_SENSOR_FAULT "start:duration" in seconds, the CO2 sensors drop off the bus for that window
+//                       (a flaky Port-A cable), e.g. NATIVE_SENSOR_FAULT=60:10
+//   NATIVE_RTC_EPOCH    RTC time at power up, seconds since 1970 UTC (default: host clock)
+//   NATIVE_SD_DIR       Host directory used as the SD card (default ./sd_card)
+//   NATIVE_NO_SD        When set to 1, no SD card is inserted
+//   NATIVE_NO_WIFI      When set to 1, the WiFi access point is out of range
+//   NATIVE_NO_NTP       When set to 1, the NTP server never answers
+//
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace hal_native {
+
+// Firmware clock
+void init(int argc, char **argv);
+bool should_exit(void);
+void request_exit(void);
+void advance_ms(uint32_t ms);  // Move the firmware clock forward without sleeping
+uint64_t micros64(void);
+
+// I2C bus statistics, counted per address phase (one write or read transfer)
+struct i2c_stats_t {
+  uint32_t transactions;
+  uint32_t errors;
+  uint32_t bus_resets;
+};
+const i2c_stats_t &i2c_stats(void);
+void i2c_count(bool ok);
+void i2c_count_reset(void);
+
+// SD card statistics, counted per File::write() call
+struct sd_stats_t {
+  uint32_t writes;
+  uint32_t bytes_written;
+};
+const sd_stats_t &sd_stats(void);
+void sd_count_write(size_t bytes);
+
+// Simulated peripherals
+bool sensor_present(void);
+void set_sensor_present(bool present);
+bool i2c_ack(int sda, int scl, uint8_t address);  // A device answers at this address, see TwoWire::endTransmission()
+bool sd_present(void);
+int64_t rtc_boot_epoch(void);
+const char *sd_dir(void);
+
+// User input injection, consumed by the next M5.update()
+enum button_t { btn_a,
+                btn_b,
+                btn_c };
+void touch_tap(int16_t x, int16_t y);
+void button_hold(button_t btn, uint32_t hold_ms);
+
+}  // namespace hal_native
@@ -0,0 +1,42 @@
+#pragma once
+//
+//    FILE: hal_native_internal.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: State shared between the stand-in libraries, not for use by firmware code
+//
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace hal_native {
+
+struct pending_input_t {
+  bool tap;
+  int16_t tap_x;
+  int16_t tap_y;
+  uint32_t hold_start[3];
+  uint32_t hold_until[3];
+};
+
+pending_input_t &pending_input(void);
+void sleep_ms(uint32_t ms);
+uint64_t host_ns(void);           // Host clock since start, not scaled and without skipped delays
+void task_sleep_ms(uint32_t ms);  // Always sleeps, scaled by NATIVE_TIME_SCALE, for tasks other than loop()
+void stop_tasks(void);            // Park the FreeRTOS stand-in tasks before main() returns
+
+// The room every simulated sensor measures, t in seconds of firmware time. Each sensor adds its
+// own offsets and errors
+void room_air(float t, float &co2, float &temperature, float &humidity);
+
+// A device model that takes raw commands through TwoWire::write(), and answers TwoWire::requestFrom(),
+// for commands its stand-in library doesn't have. The command handler returns false to NACK, the read
+// handler the number of bytes it answered with, 0 to NACK
+typedef bool (*i2c_command_fn)(void *device, const uint8_t *data, size_t len);
+typedef size_t (*i2c_read_fn)(void *device, uint8_t *data, size_t len);
+void i2c_device(uint8_t address, i2c_command_fn handler, i2c_read_fn reader, void *device);
+bool i2c_command(uint8_t address, const uint8_t *data, size_t len);
+size_t i2c_read(uint8_t address, uint8_t *data, size_t len);
+
+}  // namespace hal_native
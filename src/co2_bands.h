@@ -0,0 +1,54 @@
+#pragma once
+//
+//    FILE: co2_bands.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: CO2 level bands, shared by the RGB LEDs, LCD text, semi circular gauge and bargraph
+//
+// Bands from https://www.kane.co.uk/knowledge-centre/what-are-safe-levels-of-co-and-co2-in-rooms
+// assuming indoor CO2 levels. To use different thresholds (e.g. a local standard) edit this
+// table only, every screen and the LEDs follow it.
+//
+
+#include <FastLED.h>
+#include <M5Unified.h>
+
+struct co2_band_t {
+  uint16_t max_ppm;      // Highest CO2 in this band, the band starts after the previous band's max_ppm
+  uint32_t led_colour;   // RGB LED colour
+  int32_t lcd_colour;    // LCD text and bargraph colour
+  int32_t gauge_colour;  // Semi circular gauge scale colour
+  const char *msg;       // Effect on people
+};
+
+// Must be in increasing order of max_ppm, the last band must end at 65535
+constexpr co2_band_t co2_bands[] = {
+    // Zero is normally a bad connection with the sensor, PINK indicates an error
+    {0, CRGB::Pink, TFT_MAGENTA, TFT_MAGENTA, "Bad CO2 read :("},
+
+    // CO2 400 - 1000: OK good air exchange
+    // Should never be below 400, but wind currents on the sensor can make this happen
+    {1000, CRGB::Green, TFT_GREEN, TFT_DARKGREEN, "Good air quality"},
+
+    // CO2 1000 - 2000: Drowsy and poor air
+    {2000, CRGB::Yellow, TFT_YELLOW, TFT_ORANGE, "Drowsy, poor air"},
+
+    // Headaches, sleepiness and stagnant, stale, stuffy air.
+    // Poor concentration, loss of attention, increased heart rate and slight nausea may be present.
+    // 5,000 is max value reported by Sensirion SCD-30 (I've actually seen 6,250 but that's not as per the datasheet)
+    {5000, CRGB::Red, TFT_RED, TFT_RED, "Headache, sleepy"},
+
+    // Workplace 8-hr exposure limit, 10,000 is max value reported by Sensirion SCD-30
+    {65535, CRGB::Red, TFT_RED, TFT_RED, "8-hr exposure limit"},
+};
+
+#define co2_band_count (sizeof(co2_bands) / sizeof(co2_bands[0]))
+
+// Band for a CO2 level, counts the bands below co2 rather than branching on each one
+inline const co2_band_t &co2_to_band(uint16_t co2) {
+  uint8_t i = 0;
+  for (uint8_t b = 0; b < co2_band_count - 1; b++)
+    i += co2 > co2_bands[b].max_ppm;
+  return co2_bands[i];
+}
@@ -0,0 +1,78 @@
+#pragma once
+//
+//    FILE: co2_bargraph_lut.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: co2_to_bargraph_ht() from lookup tables, replaces two log() calls per bar
+//
+// Generated from the original floating point formula, evaluated for every ppm 0..65535:
+//   bar_height = (uint16_t)(30.0 * (log(max(co2, 400)) / log(2.0) - 8.64)), capped at 110
+// co2_to_bargraph_ht() matches it for every uint16_t ppm, test/test_bargraph_lut checks that with
+// pio test -e native. Regenerate both tables if the formula, the 400 ppm floor or the sprite
+// height changes.
+//
+
+#include <stdint.h>
+
+#define co2_bar_ht_max       110  // Tallest bar, co2_hist_spr_h - 30
+#define co2_bar_lut_base_ppm 400  // ppm of the first bucket
+#define co2_bar_lut_shift    3    // 8 ppm per bucket, closer than the 9 ppm minimum gap between heights
+
+// Lowest ppm drawn with each bar height, co2_bar_ht_ppm[h] for h = 0..co2_bar_ht_max
+constexpr uint16_t co2_bar_ht_ppm[co2_bar_ht_max + 1] = {
+    0, 409, 418, 428, 438, 448, 459, 469, 480, 492, 503, 515,
+    527, 539, 552, 565, 578, 591, 605, 619, 634, 649, 664, 679,
+    695, 711, 728, 745, 762, 780, 798, 817, 836, 856, 876, 896,
+    917, 938, 960, 983, 1006, 1029, 1053, 1078, 1103, 1129, 1155, 1182,
+    1210, 1238, 1267, 1297, 1327, 1358, 1390, 1422, 1455, 1489, 1524, 1560,
+    1596, 1634, 1672, 1711, 1751, 1792, 1834, 1876, 1920, 1965, 2011, 2058,
+    2106, 2155, 2206, 2257, 2310, 2364, 2419, 2476, 2534, 2593, 2653, 2715,
+    2779, 2844, 2910, 2978, 3048, 3119, 3192, 3267, 3343, 3421, 3501, 3583,
+    3667, 3752, 3840, 3930, 4021, 4115, 4212, 4310, 4411, 4514, 4619, 4727,
+    4838, 4951, 5067,
+};
+
+// Bar height at the first ppm of each bucket, the height is this or one more
+constexpr uint8_t co2_bar_ht_lut[] = {
+    0, 0, 1, 2, 3, 4, 5, 5, 6, 7, 8, 8, 9, 10, 10, 11, 12, 12, 13, 14,
+    14, 15, 15, 16, 17, 17, 18, 18, 19, 19, 20, 20, 21, 22, 22, 23, 23, 24, 24, 25,
+    25, 26, 26, 26, 27, 27, 28, 28, 29, 29, 30, 30, 30, 31, 31, 32, 32, 33, 33, 33,
+    34, 34, 35, 35, 35, 36, 36, 36, 37, 37, 38, 38, 38, 39, 39, 39, 40, 40, 40, 41,
+    41, 41, 42, 42, 42, 43, 43, 43, 44, 44, 44, 44, 45, 45, 45, 46, 46, 46, 47, 47,
+    47, 47, 48, 48, 48, 49, 49, 49, 49, 50, 50, 50, 50, 51, 51, 51, 52, 52, 52, 52,
+    53, 53, 53, 53, 54, 54, 54, 54, 55, 55, 55, 55, 56, 56, 56, 56, 56, 57, 57, 57,
+    57, 58, 58, 58, 58, 59, 59, 59, 59, 59, 60, 60, 60, 60, 60, 61, 61, 61, 61, 62,
+    62, 62, 62, 62, 63, 63, 63, 63, 63, 64, 64, 64, 64, 64, 65, 65, 65, 65, 65, 65,
+    66, 66, 66, 66, 66, 67, 67, 67, 67, 67, 68, 68, 68, 68, 68, 68, 69, 69, 69, 69,
+    69, 69, 70, 70, 70, 70, 70, 70, 71, 71, 71, 71, 71, 71, 72, 72, 72, 72, 72, 72,
+    73, 73, 73, 73, 73, 73, 74, 74, 74, 74, 74, 74, 74, 75, 75, 75, 75, 75, 75, 76,
+    76, 76, 76, 76, 76, 76, 77, 77, 77, 77, 77, 77, 77, 78, 78, 78, 78, 78, 78, 78,
+    79, 79, 79, 79, 79, 79, 79, 80, 80, 80, 80, 80, 80, 80, 80, 81, 81, 81, 81, 81,
+    81, 81, 82, 82, 82, 82, 82, 82, 82, 82, 83, 83, 83, 83, 83, 83, 83, 83, 84, 84,
+    84, 84, 84, 84, 84, 84, 85, 85, 85, 85, 85, 85, 85, 85, 86, 86, 86, 86, 86, 86,
+    86, 86, 86, 87, 87, 87, 87, 87, 87, 87, 87, 88, 88, 88, 88, 88, 88, 88, 88, 88,
+    89, 89, 89, 89, 89, 89, 89, 89, 89, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 91,
+    91, 91, 91, 91, 91, 91, 91, 91, 92, 92, 92, 92, 92, 92, 92, 92, 92, 92, 93, 93,
+    93, 93, 93, 93, 93, 93, 93, 93, 94, 94, 94, 94, 94, 94, 94, 94, 94, 94, 95, 95,
+    95, 95, 95, 95, 95, 95, 95, 95, 95, 96, 96, 96, 96, 96, 96, 96, 96, 96, 96, 97,
+    97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 98, 98, 98, 98, 98, 98, 98, 98, 98, 98,
+    98, 98, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 100, 100, 100, 100, 100, 100, 100,
+    100, 100, 100, 100, 100, 101, 101, 101, 101, 101, 101, 101, 101, 101, 101, 101, 101, 102, 102, 102,
+    102, 102, 102, 102, 102, 102, 102, 102, 102, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103,
+    103, 103, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 105, 105, 105, 105, 105,
+    105, 105, 105, 105, 105, 105, 105, 105, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106,
+    106, 107, 107, 107, 107, 107, 107, 107, 107, 107, 107, 107, 107, 107, 107, 108, 108, 108, 108, 108,
+    108, 108, 108, 108, 108, 108, 108, 108, 108, 109, 109, 109, 109, 109, 109, 109, 109, 109, 109, 109,
+    109, 109, 109, 109,
+};
+
+// Convert co2 value into a bargraph height in pixels, one table lookup and one compare
+// Use google sheets to calculate the scale factor
+// https://docs.google.com/spreadsheets/d/1Qu3fMzD7Rvy_9NZa7CwBIezJ-XfksOBFPso_ldFfgO4/edit#gid=0
+inline uint16_t co2_to_bargraph_ht(uint16_t co2) {
+  if (co2 < co2_bar_lut_base_ppm) return 0;
+  if (co2 >= co2_bar_ht_ppm[co2_bar_ht_max]) return co2_bar_ht_max;
+  uint8_t bar_height = co2_bar_ht_lut[(co2 - co2_bar_lut_base_ppm) >> co2_bar_lut_shift];
+  return bar_height + (co2 >= co2_bar_ht_ppm[bar_height + 1]);
+}
@@ -0,0 +1,265 @@
+//
+//    FILE: co2_driver.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: One driver per CO2 sensor type, found on the I2C bus at power up by CO2_generic::begin()
+//
+//
+//  HISTORY:
+//  0.0.1   2026-10-17  initial version, the SENSOR_IS_* code from CO2_generic
+//
+
+#include "co2_driver.h"
+
+#define scd41_frc_shift 0x8000  // FRC correction is returned offset by this
+
+// Sensirion CRC-8 over each data word, polynomial 0x31, initial value 0xFF
+static uint8_t scd41_crc(const uint8_t *data, uint8_t len) {
+  uint8_t crc = 0xFF;
+  for (uint8_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+  }
+  return crc;
+}
+
+bool CO2_driver::set_settings(float t_offset, uint16_t altitude, bool asc) {
+  (void)t_offset;
+  (void)altitude;
+  (void)asc;
+  return true;  // Not supported by this sensor
+}
+
+bool CO2_driver::get_settings(float &t_offset, uint16_t &altitude, bool &asc) {
+  t_offset = 0;
+  altitude = 0;
+  asc = false;
+  return true;
+}
+
+/////////////////////////////////////////////////////
+//
+// SCD-41
+//
+bool CO2_scd41::attach(TwoWire &wire, int sda, int scl) {
+  (void)sda;
+  (void)scl;
+  _sensor.begin(wire);
+  _wire = &wire;
+  return true;
+}
+
+bool CO2_scd41::begin(void) {
+  _sensor.stopPeriodicMeasurement();  // In case ESP32 just reset and SCD-41 already sending periodic updates
+  return start();
+}
+
+bool CO2_scd41::start(void) {
+  return _sensor.startPeriodicMeasurement() == 0;
+}
+
+bool CO2_scd41::stop(void) {
+  return command(scd41_cmd_stop);
+}
+
+bool CO2_scd41::start_low_power(void) {
+  return _sensor.startLowPowerPeriodicMeasurement() == 0;
+}
+
+// Sent here rather than with the library's measureSingleShot(), which waits out the 5 s
+// measurement. The sample is read like a periodic one, once data_ready()
+bool CO2_scd41::single_shot(void) {
+  return command(scd41_cmd_single_shot);
+}
+
+int8_t CO2_scd41::data_ready(void) {
+  uint16_t data_ready = 0;
+  if (_sensor.getDataReadyStatus(data_ready)) return -1;
+  return (data_ready & 0x7FF) ? 1 : 0;  // New data is ready when lower 11-bits is > 0
+}
+
+bool CO2_scd41::read(uint16_t &co2_level, float &temperature, float &humidity) {
+  if (_sensor.readMeasurement(co2_level, temperature, humidity) == 0) return true;
+  Serial.println("Error reading CO2 sensor during readMeasurement()");
+  return false;
+}
+
+bool CO2_scd41::factory_reset(void) {
+  return command(scd41_cmd_factory_reset);
+}
+
+bool CO2_scd41::frc_begin(uint16_t target) {
+  return command(scd41_cmd_frc, target);
+}
+
+// The correction is read back co2_frc_ms after frc_begin()
+bool CO2_scd41::frc_result(int16_t &correction) {
+  uint8_t data[3] = {};
+  bool read_ok = _wire->requestFrom((uint16_t)scd4x_i2c_addr, (uint8_t)3) == 3;
+  for (uint8_t i = 0; read_ok && i < 3; i++) data[i] = (uint8_t)_wire->read();
+  uint16_t frc = (uint16_t)(data[0] << 8 | data[1]);
+  // Correction is = correction - 0x8000 = correction - scd41_frc_shift
+  Serial.printf("%s cal %s, correction=%d, [correction-%d]=%d\n",
+                name(), read_ok ? "read" : "read error", frc, scd41_frc_shift, frc - scd41_frc_shift);
+  correction = frc - scd41_frc_shift;
+  return read_ok && scd41_crc(data, 2) == data[2] && frc != 0xFFFF;
+}
+
+// Command code, then for a command with an argument the argument and its CRC, as the datasheet
+bool CO2_scd41::command(uint16_t cmd) {
+  _wire->beginTransmission(scd4x_i2c_addr);
+  _wire->write(cmd >> 8);
+  _wire->write(cmd & 0xFF);
+  return _wire->endTransmission() == 0;
+}
+
+bool CO2_scd41::command(uint16_t cmd, uint16_t arg) {
+  uint8_t data[2] = {(uint8_t)(arg >> 8), (uint8_t)(arg & 0xFF)};
+  _wire->beginTransmission(scd4x_i2c_addr);
+  _wire->write(cmd >> 8);
+  _wire->write(cmd & 0xFF);
+  _wire->write(data[0]);
+  _wire->write(data[1]);
+  _wire->write(scd41_crc(data, 2));
+  return _wire->endTransmission() == 0;
+}
+
+// Measurement is stopped, start() again afterwards
+bool CO2_scd41::set_settings(float t_offset, uint16_t altitude, bool asc) {
+  uint16_t error = false;
+
+  // Stop potentially previously started measurement - prevents a I2C "NACK" reponse with .startPeriodicMeasurement()
+  _sensor.stopPeriodicMeasurement();
+  error = _sensor.setTemperatureOffset(t_offset);
+  Serial.printf("Set temperature offset command: %s\n", error == 0 ? "OK" : "ERROR");
+  if (error) return false;
+
+  error = _sensor.setSensorAltitude(altitude);
+  Serial.printf("Set altitude compensation command: %s\n", error == 0 ? "OK" : "ERROR");
+  if (error) return false;
+
+  error = _sensor.setAutomaticSelfCalibration((uint16_t)asc);
+  Serial.printf("Set ASC command: %s\n", error == 0 ? "OK" : "ERROR");
+  if (error) return false;
+
+  // Save new settings to SCD-41 EEPROM
+  _sensor.persistSettings();
+  delay(100);  // Just to ensure the write has occurred
+  return true;
+}
+
+// Measurement is stopped, start() again afterwards
+bool CO2_scd41::get_settings(float &t_offset, uint16_t &altitude, bool &asc) {
+  uint16_t error = false;
+  uint16_t _asc;
+  _sensor.stopPeriodicMeasurement();
+  error = _sensor.getTemperatureOffset(t_offset);
+  if (error) return false;
+  error = _sensor.getSensorAltitude(altitude);
+  if (error) return false;
+  error = _sensor.getAutomaticSelfCalibration(_asc);
+  asc = (bool)_asc;
+  return error == 0;
+}
+
+/////////////////////////////////////////////////////
+//
+// SCD-30
+//
+bool CO2_scd30::attach(TwoWire &wire, int sda, int scl) {
+  (void)sda;
+  (void)scl;
+  _wire = &wire;
+  return true;
+}
+
+bool CO2_scd30::begin(void) {
+  return _sensor.begin(*_wire, true);  // Autocalibrate = true
+}
+
+// The SparkFun library doesn't tell a bus error from no data yet
+int8_t CO2_scd30::data_ready(void) {
+  return _sensor.dataAvailable() ? 1 : 0;
+}
+
+bool CO2_scd30::read(uint16_t &co2_level, float &temperature, float &humidity) {
+  co2_level = _sensor.getCO2();
+  temperature = _sensor.getTemperature();
+  humidity = _sensor.getHumidity();
+  return true;
+}
+
+bool CO2_scd30::frc_begin(uint16_t target) {
+  return _sensor.setForcedRecalibrationFactor(target);
+}
+
+bool CO2_scd30::frc_result(int16_t &correction) {
+  uint16_t FRC_fact = 0;
+  bool cmd_ok = _sensor.getForcedRecalibration(&FRC_fact);
+  Serial.printf("%s calibration correction factor FRC=%d\n", name(), FRC_fact);
+  correction = (int16_t)FRC_fact;
+  return cmd_ok;
+}
+
+bool CO2_scd30::set_settings(float t_offset, uint16_t altitude, bool asc) {
+  bool cmd_ok = false;
+  // Note it takes some time for SCD-30 to apply this offset, give it a few minutes!
+  cmd_ok = _sensor.setTemperatureOffset(t_offset);
+  Serial.printf("Set temperature offset command: %s\n", cmd_ok ? "OK" : "ERROR");
+  if (!cmd_ok) return false;
+
+  delay(100);
+  cmd_ok = _sensor.setAltitudeCompensation(altitude);
+  Serial.printf("Set altitude compensation command: %s\n", cmd_ok ? "OK" : "ERROR");
+  if (!cmd_ok) return false;
+
+  // This is redundant becuase begin() lets you specify if ASC is ON or OFF
+  delay(100);
+  cmd_ok = _sensor.setAutoSelfCalibration(asc);
+  Serial.printf("Set ASC command: %s\n", cmd_ok ? "OK" : "ERROR");
+  return cmd_ok;
+}
+
+bool CO2_scd30::get_settings(float &t_offset, uint16_t &altitude, bool &asc) {
+  delay(50);  // Need a small delay for SCD-30 temperature offset, otherwise reads zero...why?
+  t_offset = _sensor.getTemperatureOffset();
+  altitude = _sensor.getAltitudeCompensation();
+  asc = _sensor.getAutoSelfCalibration();
+  return true;
+}
+
+/////////////////////////////////////////////////////
+//
+// SGP-30
+//
+// Each measurement is requested as the last one is read, so it has a whole period to complete
+// (12 ms) and the requests stay one second apart
+bool CO2_sgp30::attach(TwoWire &wire, int sda, int scl) {
+  (void)wire;  // The library was built with Wire
+  return _sensor.begin(sda, scl);
+}
+
+// Not GenericReset(), that is an I2C general call and would reset the other sensors on the bus too
+bool CO2_sgp30::begin(void) {
+  return start();
+}
+
+// First measurement, also after a bus reset
+bool CO2_sgp30::start(void) {
+  _sensor.request();
+  _request_ms = millis();
+  return true;
+}
+
+int8_t CO2_sgp30::data_ready(void) {
+  if (millis() - _request_ms < sgp30_period_ms) return 0;
+  return _sensor.read() ? 1 : -1;
+}
+
+bool CO2_sgp30::read(uint16_t &co2_level, float &temperature, float &humidity) {
+  co2_level = _sensor.getCO2();
+  temperature = 0;  // Temperature and humidity not supported by this sensor
+  humidity = 0;
+  return start();
+}
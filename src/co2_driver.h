@@ -0,0 +1,181 @@
+#pragma once
+//
+//    FILE: co2_driver.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: One driver per CO2 sensor type, found on the I2C bus at power up by CO2_generic::begin()
+//
+// Each driver is a thin wrapper round the sensor's own library: one method per sensor command, never
+// waiting between commands. The waits, retries, calibration steps and I2C fault recovery are the
+// same for every sensor and stay in CO2_generic, which only asks the driver what the sensor can do
+// (features()) and how often it measures (period_ms()).
+//
+// The drivers are final, so code that knows which one it holds (CO2_generic's per sample poll)
+// calls them directly rather than through the vtable. Everything else goes through CO2_driver.
+//
+
+#include <Wire.h>
+
+#include "Arduino.h"
+#include "SGP30.h"
+#include "SensirionI2CScd4x.h"
+#include "SparkFun_SCD30_Arduino_Library.h"
+#include "co2_fusion.h"
+
+// What the sensor can do
+#define co2_feature_rh_t        0x01  // Temperature and humidity as well as CO2
+#define co2_feature_frc         0x02  // Forced recalibration to a known CO2 level
+#define co2_feature_reset       0x04  // Factory reset, clears the calibration history
+#define co2_feature_settings    0x08  // Temperature offset, altitude and ASC (automatic self calibration)
+#define co2_feature_stop        0x10  // Measurement must be stopped for a reset or recalibration, then started again
+#define co2_feature_ndir        0x20  // Measures CO2 itself (NDIR or photoacoustic), not an estimate from other gases
+#define co2_feature_low_power   0x40  // Low power periodic measurement, see scd41_low_power_ms
+#define co2_feature_single_shot 0x80  // One measurement on request, idle in between, see scd41_single_shot_ms
+
+// I2C addresses, 7 bit
+#define scd4x_i2c_addr 0x62
+#define scd30_i2c_addr 0x61
+#define sgp30_i2c_addr 0x58
+
+#define sgp30_period_ms 1000  // measure_iaq every second, for the sensor's baseline compensation
+
+// SCD-41 measurement modes, from the datasheet
+#define scd41_low_power_ms    30000   // start_low_power_periodic_measurement interval
+#define scd41_single_shot_ms  5000    // measure_single_shot execution time, the sensor doesn't answer meanwhile
+#define scd41_cmd_single_shot 0x219D  // measure_single_shot command code, see CO2_scd41::single_shot()
+
+// SCD-41 commands sent without the library, which waits out their execution time inside the call.
+// CO2_generic waits instead, between its non-blocking steps
+#define scd41_cmd_stop          0x3F86  // stop_periodic_measurement, 500 ms
+#define scd41_cmd_factory_reset 0x3632  // perform_factory_reset, 1200 ms
+#define scd41_cmd_frc           0x362F  // perform_forced_recalibration, 400 ms before the correction can be read
+
+enum co2_sensor_t : uint8_t {
+  co2_sensor_none,
+  co2_sensor_scd41,
+  co2_sensor_scd30,
+  co2_sensor_sgp30,
+};
+
+class CO2_driver {
+ public:
+  virtual co2_sensor_t type(void) const = 0;
+  virtual const char *name(void) const = 0;
+  virtual uint8_t address(void) const = 0;
+  virtual uint32_t period_ms(void) const = 0;  // Time between samples
+  virtual uint8_t features(void) const = 0;    // co2_feature_*
+  virtual co2_accuracy_t accuracy(void) const = 0;
+
+  virtual bool attach(TwoWire &wire, int sda, int scl) = 0;  // Point the library at the bus, after a bus reset too
+  virtual bool begin(void) = 0;                              // First start after the sensor is found
+  virtual bool start(void) { return true; }                  // Start measuring again, after stop() or a bus reset
+  virtual bool stop(void) { return true; }                   // Returns at once, the caller waits before the next command
+  virtual bool start_low_power(void) { return false; }  // Instead of start(), co2_feature_low_power
+  virtual bool single_shot(void) { return false; }      // Start one measurement from idle, co2_feature_single_shot
+  virtual int8_t data_ready(void) = 0;  // 1 = a sample is ready, 0 = not yet, -1 = I2C error
+  virtual bool read(uint16_t &co2_level, float &temperature, float &humidity) = 0;
+
+  virtual bool factory_reset(void) { return false; }  // Returns at once, as stop()
+  virtual bool frc_begin(uint16_t target) {  // Forced recalibration, frc_result() after co2_frc_ms
+    (void)target;
+    return false;
+  }
+  virtual bool frc_result(int16_t &correction) {
+    (void)correction;
+    return false;
+  }
+
+  // Sensors without co2_feature_settings accept anything and read back zero
+  virtual bool set_settings(float t_offset, uint16_t altitude, bool asc);
+  virtual bool get_settings(float &t_offset, uint16_t &altitude, bool &asc);
+};
+
+/////////////////////////////////////////////////////
+//
+// SENSIRION SCD-41, photoacoustic CO2, temperature and humidity, 5 s periodic measurement
+//
+class CO2_scd41 final : public CO2_driver {
+ public:
+  co2_sensor_t type(void) const override { return co2_sensor_scd41; }
+  const char *name(void) const override { return "SCD-41"; }
+  uint8_t address(void) const override { return scd4x_i2c_addr; }
+  uint32_t period_ms(void) const override { return 5000; }
+  uint8_t features(void) const override {
+    return co2_feature_rh_t | co2_feature_frc | co2_feature_reset | co2_feature_settings | co2_feature_stop | co2_feature_ndir |
+           co2_feature_low_power | co2_feature_single_shot;
+  }
+  co2_accuracy_t accuracy(void) const override { return {40, 5}; }
+
+  bool attach(TwoWire &wire, int sda, int scl) override;
+  bool begin(void) override;
+  bool start(void) override;
+  bool stop(void) override;
+  bool start_low_power(void) override;
+  bool single_shot(void) override;
+  int8_t data_ready(void) override;
+  bool read(uint16_t &co2_level, float &temperature, float &humidity) override;
+  bool factory_reset(void) override;
+  bool frc_begin(uint16_t target) override;
+  bool frc_result(int16_t &correction) override;
+  bool set_settings(float t_offset, uint16_t altitude, bool asc) override;
+  bool get_settings(float &t_offset, uint16_t &altitude, bool &asc) override;
+
+ private:
+  bool command(uint16_t cmd);
+  bool command(uint16_t cmd, uint16_t arg);
+
+  SensirionI2CScd4x _sensor;
+  TwoWire *_wire = nullptr;
+};
+
+/////////////////////////////////////////////////////
+//
+// SENSIRION SCD-30, NDIR CO2, temperature and humidity, 2 s continuous measurement
+//
+class CO2_scd30 final : public CO2_driver {
+ public:
+  co2_sensor_t type(void) const override { return co2_sensor_scd30; }
+  const char *name(void) const override { return "SCD-30"; }
+  uint8_t address(void) const override { return scd30_i2c_addr; }
+  uint32_t period_ms(void) const override { return 2000; }
+  uint8_t features(void) const override { return co2_feature_rh_t | co2_feature_frc | co2_feature_settings | co2_feature_ndir; }
+  co2_accuracy_t accuracy(void) const override { return {30, 3}; }
+
+  bool attach(TwoWire &wire, int sda, int scl) override;
+  bool begin(void) override;
+  int8_t data_ready(void) override;
+  bool read(uint16_t &co2_level, float &temperature, float &humidity) override;
+  bool frc_begin(uint16_t target) override;
+  bool frc_result(int16_t &correction) override;
+  bool set_settings(float t_offset, uint16_t altitude, bool asc) override;
+  bool get_settings(float &t_offset, uint16_t &altitude, bool &asc) override;
+
+ private:
+  SCD30 _sensor;
+  TwoWire *_wire = nullptr;
+};
+
+/////////////////////////////////////////////////////
+//
+// SENSIRION SGP-30, metal oxide gas sensor, equivalent CO2 (eCO2) only, measured on request
+//
+class CO2_sgp30 final : public CO2_driver {
+ public:
+  co2_sensor_t type(void) const override { return co2_sensor_sgp30; }
+  const char *name(void) const override { return "SGP-30"; }
+  uint8_t address(void) const override { return sgp30_i2c_addr; }
+  uint32_t period_ms(void) const override { return sgp30_period_ms; }
+  uint8_t features(void) const override { return 0; }
+  co2_accuracy_t accuracy(void) const override { return {100, 15}; }  // No figure for eCO2, only fused on its own
+
+  bool attach(TwoWire &wire, int sda, int scl) override;
+  bool begin(void) override;
+  bool start(void) override;
+  int8_t data_ready(void) override;
+  bool read(uint16_t &co2_level, float &temperature, float &humidity) override;
+
+ private:
+  SGP30 _sensor;
+  uint32_t _request_ms = 0;  // millis() when the measurement being read was requested
+};
@@ -0,0 +1,99 @@
+//
+//    FILE: co2_fusion.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: Combines the readings of several CO2 sensors in the same room into one value
+//
+//
+//  HISTORY:
+//  0.0.1   2026-10-17  initial version
+//
+
+#include "co2_fusion.h"
+
+#include <math.h>
+
+void CO2_fusion::clear(void) {
+  _n = 0;
+}
+
+bool CO2_fusion::add_sensor(const co2_accuracy_t &accuracy, uint32_t period_ms, bool true_co2) {
+  if (_n == co2_max_sensors) return false;
+  sensor_t &s = _sensors[_n++];
+  s = {};
+  s.accuracy = accuracy;
+  s.period_ms = period_ms;
+  s.true_co2 = true_co2;
+  return true;
+}
+
+void CO2_fusion::add(uint8_t sensor, uint32_t time_ms, uint16_t ppm) {
+  if (sensor >= _n) return;
+  sensor_t &s = _sensors[sensor];
+  if (ppm == 0) {
+    s.last = 0;  // A failed read isn't covered by holding the last good one
+    return;
+  }
+  s.sum += ppm;
+  s.count++;
+  s.last = ppm;
+  s.last_ms = time_ms;
+}
+
+// The sensor's reading over the period since the last fuse(), and start the next period
+uint16_t CO2_fusion::aligned(sensor_t &s, uint32_t time_ms) {
+  uint16_t ppm = 0;
+  if (s.count)
+    ppm = (s.sum + s.count / 2) / s.count;
+  else if (s.last && time_ms - s.last_ms <= 2 * s.period_ms)
+    ppm = s.last;  // Slower than the first sensor, or missed a sample
+  s.sum = 0;
+  s.count = 0;
+  return ppm;
+}
+
+// Inverse variance weights, the spread of each sensor is its datasheet accuracy at its own reading
+float CO2_fusion::weighted_mean(const uint16_t *sensor_co2, bool true_co2) const {
+  float sum = 0;
+  float weights = 0;
+  for (uint8_t i = 0; i < _n; i++) {
+    if (!sensor_co2[i] || _sensors[i].true_co2 != true_co2) continue;
+    float sd = _sensors[i].accuracy.ppm + sensor_co2[i] * _sensors[i].accuracy.percent / 100.0f;
+    float w = 1.0f / (sd * sd);
+    sum += w * sensor_co2[i];
+    weights += w;
+  }
+  return weights > 0 ? sum / weights : 0;
+}
+
+// sensor_co2[] gets every sensor's reading for the period, 0 for a sensor without one
+uint16_t CO2_fusion::fuse(uint32_t time_ms, uint16_t *sensor_co2, uint16_t &spread) {
+  uint16_t lo = UINT16_MAX;
+  uint16_t hi = 0;
+  for (uint8_t i = 0; i < co2_max_sensors; i++) {
+    sensor_co2[i] = i < _n ? aligned(_sensors[i], time_ms) : 0;
+    if (!sensor_co2[i]) continue;
+    if (sensor_co2[i] < lo) lo = sensor_co2[i];
+    if (sensor_co2[i] > hi) hi = sensor_co2[i];
+  }
+  spread = hi >= lo ? hi - lo : 0;
+
+  float fused = weighted_mean(sensor_co2, true);
+  if (fused == 0) fused = weighted_mean(sensor_co2, false);  // Only eCO2 readings
+  if (fused == 0) return 0;
+
+  // Moving bias and RMS of each sensor against the fused value, a plain average until there are
+  // co2_fusion_avg_n samples
+  for (uint8_t i = 0; i < _n; i++) {
+    if (!sensor_co2[i]) continue;
+    sensor_t &s = _sensors[i];
+    float diff = sensor_co2[i] - fused;
+    s.stats.samples++;
+    float k = s.stats.samples < co2_fusion_avg_n ? 1.0f / s.stats.samples : 1.0f / co2_fusion_avg_n;
+    s.stats.bias_ppm += k * (diff - s.stats.bias_ppm);
+    s.mean_sq += k * (diff * diff - s.mean_sq);
+    s.stats.rms_ppm = sqrtf(s.mean_sq);
+  }
+  return (uint16_t)lroundf(fused);
+}
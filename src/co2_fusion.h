@@ -0,0 +1,69 @@
+#pragma once
+//
+//    FILE: co2_fusion.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: Combines the readings of several CO2 sensors in the same room into one value
+//
+// Each sensor measures at its own rate (SGP-30 1 s, SCD-30 2 s, SCD-41 5 s). A fused value is made
+// once per sample of the first sensor (the slowest true CO2 sensor found), and covers the time since
+// the last one: every other sensor is averaged over that same period, so the streams line up in time
+// and a fast sensor's noise is averaged out rather than one of its samples picked. A sensor with
+// no sample in the period holds its last one for up to two of its own periods, then drops out, and
+// a sensor that failed to read drops out straight away.
+//
+// The fused value is the inverse variance weighted mean of the true CO2 sensors (NDIR and
+// photoacoustic), using each sensor's datasheet accuracy at the current level. An eCO2 sensor
+// (SGP-30) estimates CO2 from other gases, it is only fused when no true CO2 sensor has a reading,
+// but it is still compared with the fused value, which is how a cheap sensor is cross-checked.
+//
+// Disagreement is the spread of the sensors for each fused value, and per sensor the moving
+// average (bias) and RMS of its difference from the fused value.
+//
+
+#include <stdint.h>
+
+#define co2_max_sensors   3   // One of each type
+#define co2_fusion_avg_n  60  // Fused samples in the moving bias and RMS, 5 minutes of SCD-41 samples
+
+// Datasheet accuracy, +/-(ppm + percent of the reading)
+struct co2_accuracy_t {
+  uint16_t ppm;
+  uint8_t percent;
+};
+
+// How one sensor compares with the fused value
+struct co2_fusion_stats_t {
+  uint32_t samples;  // Fused values this sensor had a reading for
+  float bias_ppm;    // Moving average of sensor - fused
+  float rms_ppm;     // Moving RMS of sensor - fused
+};
+
+class CO2_fusion {
+ public:
+  void clear(void);
+  bool add_sensor(const co2_accuracy_t &accuracy, uint32_t period_ms, bool true_co2);  // In the same order as add()
+  void add(uint8_t sensor, uint32_t time_ms, uint16_t ppm);                              // Every sample, 0 = failed read
+  uint16_t fuse(uint32_t time_ms, uint16_t *sensor_co2, uint16_t &spread);              // 0 = no sensor has a reading
+  uint8_t sensors(void) const { return _n; }
+  const co2_fusion_stats_t &stats(uint8_t sensor) const { return _sensors[sensor].stats; }
+
+ private:
+  struct sensor_t {
+    co2_accuracy_t accuracy;
+    uint32_t period_ms;
+    bool true_co2;
+    uint32_t sum;        // Samples since the last fuse()
+    uint16_t count;
+    uint16_t last;       // Last good sample, held when none in the period
+    uint32_t last_ms;
+    float mean_sq;       // Moving mean of (sensor - fused) squared
+    co2_fusion_stats_t stats;
+  };
+  uint16_t aligned(sensor_t &s, uint32_t time_ms);
+  float weighted_mean(const uint16_t *sensor_co2, bool true_co2) const;
+
+  sensor_t _sensors[co2_max_sensors] = {};
+  uint8_t _n = 0;
+};
@@ -12,281 +12,588 @@
 
 #include "co2_generic.h"
 
+// Measurement scheduling. The sensor produces a sample every measurement period, so the data
+// ready status is only polled in a short window before the next sample is due
+#define co2_ready_window_ms 250  // Start polling this long before the next sample is due
+#define co2_poll_ms         50   // Poll rate inside the window, and while a sample is overdue
+
+// I2C fault recovery, one step per get_co2() call so loop() keeps running
+#define recovery_backoff_ms     1000   // Wait before the first recovery attempt
+#define recovery_backoff_max_ms 30000  // Backoff doubles after each failed attempt, up to this limit
+#define scd41_stop_ms           500    // stop_periodic_measurement execution time, from the SCD-41 datasheet
+
+// Forced recalibration waits, the drivers send these commands without waiting for them
+#define scd41_reset_ms 10000  // perform_factory_reset, required by Sensirion SCD-41 datasheet
+#define co2_frc_ms     400    // SCD-41 perform_forced_recalibration and SCD-30 setForcedRecalibrationFactor(), from the datasheets
+
+/////////////////////////////////////////////////////
+//
+// SENSOR REGISTRY
+//
+// Every sensor the firmware knows, probed at its own address on each bus. Found sensors keep this
+// order, slowest true CO2 sensor first, so the fused samples follow it and the faster sensors are
+// averaged over its period
+static CO2_scd41 scd41;
+static CO2_scd30 scd30;
+static CO2_sgp30 sgp30;
+static CO2_driver *const co2_drivers[] = {&scd41, &scd30, &sgp30};
+
+// I2C buses a CO2 sensor can be connected to, probed in this order
+struct co2_bus_t {
+  const char *name;
+  int sda;
+  int scl;
+};
+
+static const co2_bus_t co2_buses[] = {
+#if defined CO2_SDA_PIN && defined CO2_SCL_PIN
+    {"custom", CO2_SDA_PIN, CO2_SCL_PIN},  // -D CO2_SDA_PIN=n -D CO2_SCL_PIN=n for other wiring, tried first
+#endif
+    {"internal", 14, 13},  // Black "Port-C" of the battery bottom, SCD-41 fitted inside it
+    {"Port-A", 32, 33},    // Red "Port-A", external sensor
+};
+
+static const char *const co2_mode_names[] = {"periodic", "low power periodic", "single shot", "adaptive single shot"};
+
 /////////////////////////////////////////////////////
 //
 // CONSTRUCTOR
 //
 CO2_generic::CO2_generic() {
-  co2_level = 0;
-  temperature = 0.0;
-  humidity = 0.0;
   simulate_co2 = false;
-  co2_updated = false;
+  _n_sensors = 0;
+  recovery_stats = {};
 }
 
-bool CO2_generic::begin() {
-  bool begin_ok = false;
-
-#if defined SENSOR_IS_SCD30
-  Wire.begin(CO2_SDA_PIN, CO2_SCL_PIN);                       // Could use Wire1 here (2nd I2C port on ESP32)
-  begin_ok = co2_sensor.begin(Wire, true);  // Autocalibrate = true
-#elif defined SENSOR_IS_SGP30
-  begin_ok = co2_sensor.begin(CO2_SDA_PIN, CO2_SCL_PIN);
-  co2_sensor.GenericReset();
-#elif defined SENSOR_IS_SCD41
-  uint16_t retries = 0;
-  do {
-    begin_ok = Wire.begin(CO2_SDA_PIN, CO2_SCL_PIN);  // Could use Wire1 here (2nd I2C port on ESP32)
-    // Serial.printf("SCD-41 Wire.begin() = %s\n", begin_ok ? "ok" : "not ok");
-    co2_sensor.begin(Wire);
-    co2_sensor.stopPeriodicMeasurement();  // In case ESP32 just reset and SCD-41 already sending periodic updates
-    begin_ok = (bool)(co2_sensor.startPeriodicMeasurement() == 0);
-    Serial.printf("SCD-41 begin() = %s\n", begin_ok ? "ok" : "not ok");
-    delay(10);
-  } while (!begin_ok && retries++ < 2);
+// Every sensor that answers on a bus, returns how many
+uint8_t CO2_generic::probe(bool *found) {
+  uint8_t n = 0;
+  for (uint8_t d = 0; d < sizeof(co2_drivers) / sizeof(co2_drivers[0]); d++) {
+    Wire.beginTransmission(co2_drivers[d]->address());
+    found[d] = Wire.endTransmission() == 0;  // Something answered at this address
+    if (found[d]) n++;
+  }
+  return n;
+}
 
-#endif
+// Each bus is started in turn and each sensor's address probed. The sensors can be swapped for
+// other types, added or moved to the other port, between power ups without building a different
+// firmware. All the sensors are read through Wire, so they have to share a bus: the one with the
+// most sensors is used (the first one on a tie), Wire1's I2C port is taken by M5Unified for the
+// Core2's own internal bus
+bool CO2_generic::begin(co2_mode_t mode) {
+  const uint8_t n_buses = sizeof(co2_buses) / sizeof(co2_buses[0]);
+  bool found[sizeof(co2_drivers) / sizeof(co2_drivers[0])];
+  uint8_t bus_n[n_buses];
+  uint8_t best_n = 0;
+
+  _n_sensors = 0;
+  _fusion.clear();
+  _scheduler.clear();
+  for (uint8_t bus = 0; bus < n_buses; bus++) {
+    // Wire.begin() keeps the old pins if the bus is already started. With no sensor found Wire is
+    // left on the last bus, Port-A, for the lux sensor
+    Wire.end();
+    Wire.begin(co2_buses[bus].sda, co2_buses[bus].scl);
+    bus_n[bus] = probe(found);
+    if (bus_n[bus] > best_n) {
+      best_n = bus_n[bus];
+      _bus = bus;
+    }
+  }
+  if (!best_n) return false;
+  for (uint8_t bus = 0; bus < n_buses; bus++)
+    if (bus != _bus && bus_n[bus])
+      Serial.printf("%d CO2 sensor(s) on the %s I2C bus not used, they must share one bus\n", bus_n[bus], co2_buses[bus].name);
+
+  const co2_bus_t &bus = co2_buses[_bus];
+  if (_bus != n_buses - 1) {
+    Wire.end();
+    Wire.begin(bus.sda, bus.scl);
+  }
+  probe(found);
+
+  // Registry order, so sensor 0 is an SCD-41 or SCD-30 whenever one is fitted
+  for (uint8_t d = 0; d < sizeof(co2_drivers) / sizeof(co2_drivers[0]); d++) {
+    if (!found[d]) continue;
+    CO2_driver *driver = co2_drivers[d];
+    Serial.printf("%s found at 0x%02X on the %s I2C bus, SDA=%d SCL=%d\n", driver->name(), driver->address(),
+                  bus.name, bus.sda, bus.scl);
+    bool begin_ok = false;
+    uint16_t retries = 0;
+    do {
+      begin_ok = driver->attach(Wire, bus.sda, bus.scl) && driver->begin();
+      Serial.printf("%s begin() = %s\n", driver->name(), begin_ok ? "ok" : "not ok");
+      delay(10);
+    } while (!begin_ok && retries++ < 2);
+    if (!begin_ok) continue;
+
+    sensor_t &sensor = _sensors[_n_sensors++];
+    sensor = {};
+    sensor.driver = driver;
+    sensor.type = driver->type();
+    sensor.features = driver->features();
+
+    // Only sensor 0 changes mode, driver->begin() has started it measuring periodically
+    set_mode(sensor, co2_mode_periodic);
+    if (_n_sensors == 1 && mode != co2_mode_periodic) {
+      uint8_t needs = mode == co2_mode_low_power ? co2_feature_low_power : co2_feature_single_shot;
+      if (sensor.features & needs) {
+        set_mode(sensor, mode);
+        driver->stop();
+        delay(scd41_stop_ms);
+        start(sensor);
+      } else
+        Serial.printf("%s has no %s mode\n", driver->name(), co2_mode_names[mode]);
+    }
+    Serial.printf("%s measuring in %s mode\n", driver->name(), co2_mode_names[sensor.mode]);
+    if (_n_sensors == 1) {
+      read_settings();  // No single shot is in progress yet
+      restart();
+    }
+
+    _fusion.add_sensor(driver->accuracy(), sensor.period_ms, sensor.features & co2_feature_ndir);
+    schedule_first_read(sensor);
+  }
+  return _n_sensors > 0;
+}
+
+uint32_t CO2_generic::period_ms(void) const {
+  return _n_sensors ? _sensors[0].period_ms : co2_sim_period_ms;
+}
+
+uint32_t CO2_generic::max_period_ms(void) const {
+  if (mode() == co2_mode_single_shot) return co2_single_shot_interval_ms;
+  if (mode() == co2_mode_adaptive) return co2_adapt_max_ms;
+  return period_ms();
+}
 
-  return begin_ok;
+const char *CO2_generic::mode_name(void) const {
+  return co2_mode_names[mode()];
 }
 
+const char *CO2_generic::bus_name(void) const {
+  return _n_sensors ? co2_buses[_bus].name : "none";
+}
+
+bool CO2_generic::recovering(void) const {
+  for (uint8_t i = 0; i < _n_sensors; i++)
+    if (_sensors[i].recovery_state != recovery_idle) return true;
+  return false;
+}
+
+// The sensors are known once begin() has found them, so each type's poll is built against its own
+// (final) driver class and the calls made for every sample are direct, not through the vtable.
+// Returns true when a (fused) sample was published
 bool CO2_generic::get_co2(void) {
-/*************************************************************
-                            SCD-30
-*************************************************************/
-#if defined SENSOR_IS_SCD30
-  if (co2_sensor.dataAvailable()) {
-    co2_level = co2_sensor.getCO2();
-    temperature = co2_sensor.getTemperature();
-    humidity = co2_sensor.getHumidity();
-    co2_updated = true;
-    return true;
-  } else
-    return false;
+  uint32_t now = millis();
+  bool cal_stopped = calibration_step(now);  // Sensor 0 stopped for a factory reset or recalibration
+  settings_step();
+  bool published = false;
+
+  // Sensor 0 last, so a sample another sensor has ready now goes into this fused value, not the next
+  for (uint8_t i = _n_sensors; i-- > 0;) {
+    if (i == 0 && cal_stopped) continue;
+    sensor_t &sensor = _sensors[i];
+    switch (sensor.type) {
+      case co2_sensor_scd41:
+        published |= poll(static_cast<CO2_scd41 &>(*sensor.driver), i, now);
+        break;
+      case co2_sensor_scd30:
+        published |= poll(static_cast<CO2_scd30 &>(*sensor.driver), i, now);
+        break;
+      case co2_sensor_sgp30:
+        published |= poll(static_cast<CO2_sgp30 &>(*sensor.driver), i, now);
+        break;
+      default:
+        break;
+    }
+  }
+  return published;
+}
 
-/*************************************************************
-                            SGP-30
-*************************************************************/
-#elif defined SENSOR_IS_SGP30
-  static uint32_t last_time = 0;
-  if (millis() > last_time + 1000) {
-    last_time = millis();
-    co2_sensor.request();
+template <class driver_t>
+bool CO2_generic::poll(driver_t &driver, uint8_t i, uint32_t now) {
+  sensor_t &sensor = _sensors[i];
+  if (sensor.recovery_state != recovery_idle) {
+    recover_i2c(sensor, now);
+    return false;
   }
 
-  if (co2_sensor.read()) {
-    co2_updated = true;
-    co2_level = co2_sensor.getCO2();
-    temperature = 0;  // Not supported by this sensor
-    humidity = 0;     // Not supported by this sensor
-    return true;
-  } else
+  // Idle between single shots until the next one is due, or asked for
+  if (sensor.single_shots() && !sensor.shot_pending) {
+    if (!(i == 0 && _measure_now) && (int32_t)(now - sensor.next_shot_ms) < 0) return false;
+    _measure_now = false;
+    if (!driver.single_shot()) return fault(i, now);
+    sensor.shot_pending = true;
+    sensor.next_poll_ms = now + sensor.period_ms;  // Not inside the window, the sensor doesn't answer until it's done
     return false;
+  }
+
+  // Stay off the I2C bus until the next sample is due
+  if ((int32_t)(now - sensor.next_poll_ms) < 0) return false;
 
-/*************************************************************
-                            SCD-41
-*************************************************************/
-#elif defined SENSOR_IS_SCD41
-  uint16_t data_ready = 0;
-  uint16_t error = co2_sensor.getDataReadyStatus(data_ready);
-  data_ready &= 0x7FF;  // New data is ready when lower 11-bits is > 0
-  if (error) {
-    co2_level = 0;       // Zero displayed as NaN
-    co2_updated = true;  // Force update of LCD
-    Serial.println("Error reading CO2 sensor during getDataReadyStatus(). Restarting I2C bus...");
-    delay(1000);
-    // If I2C sensor had bad connection, that has now come good, need to restart I2C bus
-    begin();
+  int8_t data_ready = driver.data_ready();
+  if (data_ready < 0) {
+    return fault(i, now);
   } else if (data_ready) {
-    error = co2_sensor.readMeasurement(co2_level, temperature, humidity);
-    if (error) {
-      Serial.println("Error reading CO2 sensor during readMeasurement()");
-      co2_level = 0;
-    } else {
-      co2_updated = true;
-    }
+    uint16_t co2_level = 0;
+    float temperature = 0.0;
+    float humidity = 0.0;
+    if (!driver.read(co2_level, temperature, humidity)) co2_level = 0;
+    if (sensor.single_shots())
+      shot_done(sensor, now, co2_level);
+    else
+      // Sample became ready within the last poll interval, next one is one period later
+      sensor.next_poll_ms = now + sensor.period_ms - co2_ready_window_ms;
+    return sampled(i, now, co2_level, temperature, humidity);
   }
-  return (data_ready > 0);
-
-#endif
+  // Not ready yet (early in the window, or the sample is overdue), check again shortly
+  sensor.next_poll_ms = now + co2_poll_ms;
+  return false;
 }
 
-void CO2_generic::factory_reset(void) {
-#if defined SENSOR_IS_SCD30
-  // Not supported by this sensor
-
-#elif defined SENSOR_IS_SGP30
-  // Not supported by this sensor
-
-#elif defined SENSOR_IS_SCD41
-  // Reset to clear out previous calibration
-  co2_sensor.stopPeriodicMeasurement();
-  co2_sensor.performFactoryReset();
-  delay(10000);  // Required by Sensirion SCD-41 datasheet
-  co2_sensor.startPeriodicMeasurement();
-#endif
+// I2C error, the sensor is left alone while the bus is reset and it is started again
+bool CO2_generic::fault(uint8_t i, uint32_t now) {
+  sensor_t &sensor = _sensors[i];
+  bool published = sampled(i, now, 0, 0, 0);  // Zero displayed as NaN, if no other sensor has a reading
+  Serial.printf("Error reading %s during data ready check. Restarting I2C bus...\n", sensor.driver->name());
+  // If I2C sensor had bad connection, that has now come good, need to restart I2C bus
+  recovery_stats.faults++;
+  sensor.recovery_start_ms = now;
+  sensor.recovery_wait_ms = recovery_backoff_ms;
+  sensor.recovery_due_ms = now + sensor.recovery_wait_ms;
+  sensor.recovery_state = recovery_backoff;
+  return published;
 }
 
-int16_t CO2_generic::calibrate(uint16_t target) {
-#if defined SENSOR_IS_SCD30
-  bool cmd_ok = false;
-  uint16_t FRC_fact;
-
-  cmd_ok = co2_sensor.setForcedRecalibrationFactor(target);
-  delay(400);  // Required by Sensirion SCD-30 datasheet
-  if (cmd_ok) {
-    co2_sensor.getForcedRecalibration(&FRC_fact);
-    Serial.printf("%s calibration correction factor FRC=%d\n", co2_sensor_type_str, FRC_fact);
-    return (int16_t)FRC_fact;
-  } else
-    return 0;
+// The time to the next shot is from sample to sample, the shot itself takes period_ms of it
+void CO2_generic::shot_done(sensor_t &sensor, uint32_t now, uint16_t co2_level) {
+  uint32_t interval = sensor.mode == co2_mode_adaptive ? _scheduler.next_interval_ms(co2_level) : co2_single_shot_interval_ms;
+  sensor.shot_pending = false;
+  sensor.next_shot_ms = now + interval - sensor.period_ms;
+}
 
-#elif defined SENSOR_IS_SGP30
-  // There is no calibration function for SGP30. It is possible to read baseline value and store in EEPROM
-  // and then read this stored value at power on reset and set it in the sensor
-  return false;
+// A fused sample is published with each sample of sensor 0. While sensor 0 is stopped or
+// recovering the next sensor's samples stand in for it, no more often than sensor 0's period
+bool CO2_generic::fuse_due(uint8_t i, uint32_t now) const {
+  bool sensor0_up = _sensors[0].recovery_state == recovery_idle && !cal_busy();
+  if (i == 0) return sensor0_up;
+  if (sensor0_up) return false;
+  for (uint8_t j = 1; j < i; j++)
+    if (_sensors[j].recovery_state == recovery_idle) return false;  // An earlier sensor stands in
+  return now - _last.time_ms >= _sensors[0].period_ms - co2_ready_window_ms;
+}
 
-#elif defined SENSOR_IS_SCD41
-  const uint16_t correct_shift = 0x8000;
-  uint16_t correction = 0;
-  uint16_t error = co2_sensor.stopPeriodicMeasurement();
-  delay(500);  // Required by Sensirion SCD-41 datasheet
-  error = co2_sensor.performForcedRecalibration(target, correction);
-  delay(400);  // Required by Sensirion SCD-41 datasheet
-  co2_sensor.startPeriodicMeasurement();
-  // Correction is = correction - 0x8000 = correction - correct_shift
-  Serial.printf("%s cal error code=%d, correction=%d, [correction-%d]=%d\n",
-                co2_sensor_type_str, error, correction, correct_shift, correction - correct_shift);
-  if (error == 0 && correction != 0xFFFF)
-    return (correction - correct_shift);  // Success
+// Every sample goes into the fusion, including failed reads (0). Temperature and humidity are the
+// last read by a sensor that measures them
+bool CO2_generic::sampled(uint8_t i, uint32_t now, uint16_t co2_level, float temperature, float humidity) {
+  if (co2_level && (_sensors[i].features & co2_feature_rh_t)) {
+    _temperature = temperature;
+    _humidity = humidity;
+  }
+  _fusion.add(i, now, co2_level);
+  if (!fuse_due(i, now)) return false;
+
+  uint16_t sensor_co2[co2_max_sensors];
+  uint16_t spread = 0;
+  uint16_t fused = _fusion.fuse(now, sensor_co2, spread);
+  if (fused)
+    publish(fused, _temperature, _humidity, sensor_co2, spread);
   else
-    return 0;  // Failure
+    publish(0, 0, 0, sensor_co2, 0);
+  return true;
+}
 
-#endif
+/////////////////////////////////////////////////////
+//
+// FORCED RECALIBRATION
+//
+// A sensor with co2_feature_reset is factory reset first to clear out the previous calibration.
+// On the SCD-41 both the reset and the recalibration need periodic measurement stopped, so each
+// is a few steps with a wait between them, see calibration_step(). Only sensor 0 is calibrated,
+// the other sensors carry on measuring.
+//
+// The FRC needs the sensor to have been measuring periodically before it, and the settle check in
+// main.cpp counts 5 s samples, so a sensor in low power or single shot mode measures periodically
+// from cal_begin() until cal_end() puts it back in its configured mode
+void CO2_generic::cal_begin(bool factory_reset) {
+  _cal_correction = 0;
+  _cal_due_ms = millis();
+  _cal_mode = mode();
+  if (!has(co2_feature_frc)) {
+    // There is no calibration function for SGP30. It is possible to read baseline value and store in EEPROM
+    // and then read this stored value at power on reset and set it in the sensor
+    _cal_state = cal_failed;
+    return;
+  }
+  _cal_reset = factory_reset && has(co2_feature_reset);
+  if (_cal_mode != co2_mode_periodic) set_mode(_sensors[0], co2_mode_periodic);
+  _cal_state = _cal_reset || _cal_mode != co2_mode_periodic ? cal_reset_stop : cal_measuring;
 }
 
-bool CO2_generic::set_co2_device_settings(float t_offset, uint16_t altitude, bool asc) {
-#if defined SENSOR_IS_SCD30
-  bool cmd_ok = false;
-  // Note it takes some time for SCD-30 to apply this offset, give it a few minutes!
-  cmd_ok = co2_sensor.setTemperatureOffset(t_offset);
-  Serial.printf("Set temperature offset command: %s\n", cmd_ok ? "OK" : "ERROR");
-  if (!cmd_ok) return false;
+void CO2_generic::calibrate(uint16_t target) {
+  if (_cal_state != cal_measuring) return;
+  _cal_target = target;
+  _cal_due_ms = millis();
+  _cal_state = cal_frc_stop;
+}
 
-  delay(100);
-  cmd_ok = co2_sensor.setAltitudeCompensation(altitude);
-  Serial.printf("Set altitude compensation command: %s\n", cmd_ok ? "OK" : "ERROR");
-  if (!cmd_ok) return false;
+void CO2_generic::cal_end(void) {
+  if (_cal_state == cal_idle || cal_busy()) return;
+  if (_n_sensors && _sensors[0].mode != _cal_mode) {
+    _cal_due_ms = millis();
+    _cal_state = cal_mode_stop;
+  } else
+    _cal_state = cal_idle;
+}
 
-  // This is redundant becuase co2_sensor.begin() lets you specify if ASC is ON or OFF
-  delay(100);
-  cmd_ok = co2_sensor.setAutoSelfCalibration(asc);
-  Serial.printf("Set ASC command: %s\n", cmd_ok ? "OK" : "ERROR");
-  return cmd_ok;
+// Sensor stopped, or about to be, for a step of the reset, recalibration or mode switch
+bool CO2_generic::cal_busy(void) const {
+  co2_cal_state_t state = _cal_state;
+  return (state >= cal_reset_stop && state <= cal_reset_start) || (state >= cal_frc_stop && state <= cal_frc_start) ||
+         state >= cal_mode_stop;
+}
 
-#elif defined SENSOR_IS_SGP30
-  // Not supported by this sensor
+// One step of a factory reset or forced recalibration, once the wait after the last step is over.
+// Returns true while the sensor is stopped, so get_co2() stays off it
+bool CO2_generic::calibration_step(uint32_t now) {
+  if (!cal_busy()) return false;
+  if ((int32_t)(now - _cal_due_ms) < 0) return true;
+  bool step_ok = true;
+
+  switch (_cal_state) {
+    case cal_reset_stop:
+    case cal_frc_stop:
+      // A single shot can't be stopped, let it finish and drop it
+      if (_sensors[0].shot_pending) {
+        if ((int32_t)(now - _sensors[0].next_poll_ms) < 0) {
+          _cal_due_ms = _sensors[0].next_poll_ms;
+          return true;
+        }
+        _sensors[0].shot_pending = false;
+      }
+      if (has(co2_feature_stop)) {
+        step_ok = _sensors[0].driver->stop();
+        _cal_due_ms = now + scd41_stop_ms;
+      }
+      if (_cal_state == cal_frc_stop)
+        _cal_state = cal_frc;
+      else
+        _cal_state = _cal_reset ? cal_reset : cal_reset_start;  // Or only switching to periodic
+      break;
+
+    case cal_reset:
+      step_ok = _sensors[0].driver->factory_reset();
+      _cal_due_ms = now + scd41_reset_ms;
+      _cal_state = cal_reset_start;
+      break;
+
+    case cal_frc:
+      step_ok = _sensors[0].driver->frc_begin(_cal_target);
+      _cal_due_ms = now + co2_frc_ms;
+      _cal_state = cal_frc_start;
+      break;
+
+    case cal_reset_start:
+      read_settings();  // Back to the factory defaults
+      step_ok = restart();
+      _cal_state = cal_measuring;
+      break;
+
+    case cal_frc_start:
+      step_ok = _sensors[0].driver->frc_result(_cal_correction) && restart();
+      _cal_state = cal_done;
+      break;
+
+    // Not failed once calibrated, a sensor that doesn't restart is left to the I2C fault recovery
+    case cal_mode_stop:
+      if (has(co2_feature_stop)) {
+        _sensors[0].driver->stop();
+        _cal_due_ms = now + scd41_stop_ms;
+      }
+      _cal_state = cal_mode_start;
+      break;
+
+    case cal_mode_start:
+      set_mode(_sensors[0], _cal_mode);
+      restart();
+      _cal_state = cal_idle;
+      break;
+
+    default:
+      step_ok = false;
+      break;
+  }
 
+  if (!step_ok) {
+    Serial.printf("%s calibration failed\n", name());
+    restart();  // Whichever step failed, carry on measuring
+    _cal_state = cal_failed;
+  }
   return true;
+}
 
-#elif defined SENSOR_IS_SCD41
-  uint16_t error = false;
+// Start measuring in the sensor's mode, a single shot straight away
+bool CO2_generic::start(sensor_t &sensor) {
+  switch (sensor.mode) {
+    case co2_mode_low_power:
+      return sensor.driver->start_low_power();
+    case co2_mode_single_shot:
+    case co2_mode_adaptive:
+      sensor.shot_pending = false;
+      sensor.next_shot_ms = millis();
+      return true;
+    default:
+      return sensor.driver->start();
+  }
+}
 
-  // Stop potentially previously started measurement - prevents a I2C "NACK" reponse with .startPeriodicMeasurement()
-  co2_sensor.stopPeriodicMeasurement();
-  error = co2_sensor.setTemperatureOffset(t_offset);
-  Serial.printf("Set temperature offset command: %s\n", error == 0 ? "OK" : "ERROR");
-  if (error) return false;
+// The measurement period follows the mode, a single shot's is the time it takes
+void CO2_generic::set_mode(sensor_t &sensor, co2_mode_t mode) {
+  sensor.mode = mode;
+  if (sensor.single_shots())
+    sensor.period_ms = scd41_single_shot_ms;
+  else
+    sensor.period_ms = mode == co2_mode_low_power ? scd41_low_power_ms : sensor.driver->period_ms();
+}
 
-  error = co2_sensor.setSensorAltitude(altitude);
-  Serial.printf("Set altitude compensation command: %s\n", error == 0 ? "OK" : "ERROR");
-  if (error) return false;
+// Start sensor 0 measuring again after a command that needed it stopped
+bool CO2_generic::restart(void) {
+  bool start_ok = !has(co2_feature_stop) || start(_sensors[0]);
+  schedule_first_read(_sensors[0]);
+  return start_ok;
+}
 
-  error = co2_sensor.setAutomaticSelfCalibration((uint16_t)asc);
-  Serial.printf("Set ASC command: %s\n", error == 0 ? "OK" : "ERROR");
+// Written by settings_step(), with the sensor task locked out the values can't be half copied
+void CO2_generic::set_co2_device_settings(float t_offset, uint16_t altitude, bool asc) {
+  if (!_n_sensors) return;
+  _new_settings = {t_offset, altitude, asc};
+  _settings_due = true;
+}
 
-  if (error) {
-    return false;
-  } else {
-    // Save new settings to SCD-41 EEPROM
-    co2_sensor.persistSettings();
-    delay(100);  // Just to ensure the write has occurred
-    co2_sensor.startPeriodicMeasurement();
-    return true;
-  }
-#endif
+bool CO2_generic::get_co2_device_settings(float &t_offset, uint16_t &altitude, bool &asc) const {
+  t_offset = _settings.t_offset;
+  altitude = _settings.altitude;
+  asc = _settings.asc;
+  return _settings_ok;
 }
 
-bool CO2_generic::get_co2_device_settings(float &t_offset, uint16_t &altitude, bool &asc) {
-#if defined SENSOR_IS_SCD30
-  delay(50);  // Need a small delay for SCD-30 temperature offset, otherwise reads zero...why?
-  t_offset = co2_sensor.getTemperatureOffset();
-  altitude = co2_sensor.getAltitudeCompensation();
-  asc = co2_sensor.getAutoSelfCalibration();
-  return true;
+// With sensor 0 stopped or idle, an SCD-41 stops measuring for it, restart() it afterwards
+void CO2_generic::read_settings(void) {
+  _settings_ok = _sensors[0].driver->get_settings(_settings.t_offset, _settings.altitude, _settings.asc);
+}
 
-#elif defined SENSOR_IS_SGP30
-  t_offset = 0;
-  altitude = 0;
-  asc = false;
-  return true;
+// Write the settings from set_co2_device_settings() and read them back. A single shot can't be
+// interrupted, the sensor doesn't answer until it is done, so this waits for it to be read first
+// like calibration_step(). A sensor being recovered or calibrated is waited for too
+void CO2_generic::settings_step(void) {
+  sensor_t &sensor = _sensors[0];
+  if (!_settings_due || sensor.shot_pending || sensor.recovery_state != recovery_idle || cal_busy()) return;
+  const settings_t &set = _new_settings;
+  bool cmd_ok = sensor.driver->set_settings(set.t_offset, set.altitude, set.asc);
+  read_settings();
+  restart();
+  _settings_due = false;
+
+  if (!cmd_ok || !_settings_ok)
+    Serial.printf("Error setting %s: temperature offset=%.2f °C, altitude=%d, ASC calibration %s\n",
+                  name(), set.t_offset, set.altitude, set.asc ? "ON" : "OFF");
+  else
+    Serial.printf("%s Settings OK: temperature offset=%.2f °C, altitude=%d, ASC calibration %s\n",
+                  name(), _settings.t_offset, _settings.altitude, _settings.asc ? "ON" : "OFF");
+}
 
-#elif defined SENSOR_IS_SCD41
-  uint16_t error = false;
-  uint16_t _asc;
-  co2_sensor.stopPeriodicMeasurement();
-  error = co2_sensor.getTemperatureOffset(t_offset);
-  if (error) return false;
-  error = co2_sensor.getSensorAltitude(altitude);
-  if (error) return false;
-  error = co2_sensor.getAutomaticSelfCalibration(_asc);
-  asc = (bool)_asc;
-  if (error)
-    return false;
-  else {
-    co2_sensor.startPeriodicMeasurement();
-    return true;
+/////////////////////////////////////////////////////
+//
+// I2C FAULT RECOVERY
+//
+// Advances one sensor's recovery by at most one step, never waits. Sequence is:
+//   backoff -> bus reset -> stop measurement -> (500 ms) -> start measurement
+// A failed step goes back to backoff with double the wait time.
+//
+void CO2_generic::recover_i2c(sensor_t &sensor, uint32_t now) {
+  const co2_bus_t &bus = co2_buses[_bus];
+  bool step_ok = true;
+
+  if ((int32_t)(now - sensor.recovery_due_ms) < 0) return;
+
+  switch (sensor.recovery_state) {
+    case recovery_backoff:
+      sensor.recovery_state = recovery_bus_reset;
+      break;
+
+    case recovery_bus_reset:
+      // The other sensors share the bus, their libraries keep using Wire once it is started again
+      recovery_stats.attempts++;
+      Wire.end();
+      step_ok = Wire.begin(bus.sda, bus.scl) && sensor.driver->attach(Wire, bus.sda, bus.scl);
+      sensor.recovery_state = recovery_stop;
+      break;
+
+    case recovery_stop:
+      step_ok = sensor.driver->stop();
+      sensor.recovery_due_ms = now + scd41_stop_ms;
+      sensor.recovery_state = recovery_start;
+      break;
+
+    case recovery_start:
+      step_ok = start(sensor);
+      if (step_ok) {
+        schedule_first_read(sensor);
+        recovery_stats.recoveries++;
+        recovery_stats.last_recovery_ms = now - sensor.recovery_start_ms;
+        if (recovery_stats.last_recovery_ms > recovery_stats.max_recovery_ms)
+          recovery_stats.max_recovery_ms = recovery_stats.last_recovery_ms;
+        recovery_stats.total_recovery_ms += recovery_stats.last_recovery_ms;
+        sensor.recovery_state = recovery_idle;
+        Serial.printf("%s recovered after %u ms\n", sensor.driver->name(), recovery_stats.last_recovery_ms);
+      }
+      break;
+
+    default:
+      sensor.recovery_state = recovery_idle;
+      break;
   }
 
-#endif
+  if (!step_ok) {
+    sensor.recovery_wait_ms *= 2;
+    if (sensor.recovery_wait_ms > recovery_backoff_max_ms) sensor.recovery_wait_ms = recovery_backoff_max_ms;
+    sensor.recovery_due_ms = now + sensor.recovery_wait_ms;
+    sensor.recovery_state = recovery_backoff;
+  }
 }
 
-void CO2_generic::sim_sensor(void) {
-  static bool co2_rising = true;
-  static bool temp_rising = true;
-  static bool hum_rising = true;
-
-  // Simulate CO2
-  if (co2_rising && co2_level > 6000)
-    co2_rising = false;
-  else if (!co2_rising && co2_level < 400)
-    co2_rising = true;
-
-  if (co2_rising)
-    co2_level += 250 + random(-50, 50);
-  else
-    co2_level -= (250 + random(-50, 50));
-
-  co2_updated = true;
+// First sample arrives one measurement period after periodic measurement is (re)started. Single
+// shots are polled from when each one starts
+void CO2_generic::schedule_first_read(sensor_t &sensor) {
+  sensor.next_poll_ms = millis() + sensor.period_ms - co2_ready_window_ms;
+}
 
-  // Simulate temperature
-  if (temp_rising && temperature > 45)
-    temp_rising = false;
-  else if (!temp_rising && temperature < 10)
-    temp_rising = true;
+// Timestamp a sample and queue it for the consumer. If the consumer has fallen behind by a whole
+// queue the sample is dropped (and counted), the sensor task never waits. Without sensor_co2[]
+// (the simulation) the sample is the only sensor's
+void CO2_generic::publish(uint16_t co2_level, float temperature, float humidity, const uint16_t *sensor_co2, uint16_t spread) {
+  _last.time_ms = millis();
+  _last.co2_level = co2_level;
+  _last.temperature = temperature;
+  _last.humidity = humidity;
+  _last.flags = _cal_state != cal_idle ? co2_sample_flag_cal : 0;
+  for (uint8_t i = 0; i < co2_max_sensors; i++) _last.sensor_co2[i] = sensor_co2 ? sensor_co2[i] : (i == 0 ? co2_level : 0);
+  _last.spread = spread;
+  _samples.push(_last);
+}
 
-  if (temp_rising)
-    temperature += 10.0 + (float)random(-30, 30) / 10.0;
-  else
-    temperature -= (10.0 + (float)random(-30, 30) / 10.0);
+// Repeatable from the seed, see co2_sim.h. A trace loaded into sim_model after this replaces the scenario
+void CO2_generic::sim_begin(uint32_t seed, uint8_t scenario, uint16_t period_s) {
+  sim_model.begin(seed, scenario, period_s);
+}
 
-  if (hum_rising && humidity > 100)
-    hum_rising = false;
-  else if (!hum_rising && humidity < 10)
-    hum_rising = true;
+void CO2_generic::sim_sensor(void) {
+  uint16_t co2_level;
+  float temperature;
+  float humidity;
 
-  if (hum_rising)
-    humidity += 15.0 + (float)random(-50, 50) / 10.0;
-  else
-    humidity -= (15.0 + (float)random(-50, 50) / 10.0);
+  if (sim_model.next(co2_level, temperature, humidity))  // No sample while the sensor has dropped out
+    publish(co2_level, temperature, humidity);
 }
\ No newline at end of file
@@ -7,51 +7,187 @@
 // PURPOSE: Generic class for any CO2 sensor
 //
 
+#include <atomic>
+
 #include "Arduino.h"
+#include "co2_driver.h"
+#include "co2_scheduler.h"
+#include "co2_sim.h"
+#include "spsc_queue.h"
+
+// Sensor sample period while simulating, the same as an SCD-41
+#define co2_sim_period_ms 5000
+
+// How sensor 0 measures, where it can (co2_feature_low_power, co2_feature_single_shot). Other
+// sensors, and one without the feature, measure periodically
+enum co2_mode_t : uint8_t {
+  co2_mode_periodic,     // Every driver period_ms(), SCD-41 5 s
+  co2_mode_low_power,    // Low power periodic, scd41_low_power_ms
+  co2_mode_single_shot,  // A single shot every co2_single_shot_interval_ms, or sooner on measure_now()
+  co2_mode_adaptive,     // Single shots, as often as the air needs, see co2_scheduler.h
+};
+
+#define co2_single_shot_interval_ms 300000  // co2_mode_single_shot, the interval Sensirion's ASC assumes
+
+// Sample flags
+#define co2_sample_flag_cal 0x01  // Read while the sensor was being calibrated
+
+// One reading from the CO2 sensors, or the simulation. co2_level 0 means no sensor could be read.
+// With more than one sensor co2_level is their fused value, see co2_fusion.h
+struct co2_sample_t {
+  uint32_t time_ms;  // millis() when the sample was read
+  uint16_t co2_level;
+  float temperature;
+  float humidity;
+  uint8_t flags;                         // co2_sample_flag_*
+  uint16_t sensor_co2[co2_max_sensors];  // Each sensor over the same period, in co2.name(i) order, 0 = no reading
+  uint16_t spread;                       // Highest minus lowest of sensor_co2[], how far the sensors disagree
+};
+
+// Forced recalibration, see CO2_generic::cal_begin()
+enum co2_cal_state_t : uint8_t {
+  cal_idle,         // Not calibrating
+  cal_reset_stop,   // Factory reset (co2_feature_reset) and/or switch to periodic, no samples until cal_measuring
+  cal_reset,
+  cal_reset_start,
+  cal_measuring,    // Measuring, waiting for calibrate()
+  cal_frc_stop,     // Forced recalibration, no samples until cal_done
+  cal_frc,
+  cal_frc_start,
+  cal_done,         // Measuring with the new calibration, see cal_correction()
+  cal_failed,       // Measuring, the sensor can't be calibrated or a step failed
+  cal_mode_stop,    // Back from periodic measurement to the configured mode, no samples until cal_idle
+  cal_mode_start,
+};
 
-// These are in m platformio.ini file, but you can set them here instead if preferred
-// #define SENSOR_IS_SCD30
-// #define SENSOR_IS_SGP30
-// #define SENSOR_IS_SCD41
-
-#if defined SENSOR_IS_SCD30
-  #include "SparkFun_SCD30_Arduino_Library.h"
-  #define co2_sensor_type_str "SCD-30"
-#elif defined SENSOR_IS_SGP30
-  #include "SGP30.h"
-  #define co2_sensor_type_str "SGP-30"
-#elif defined SENSOR_IS_SCD41
-  #include "SensirionI2CScd4x.h"
-  #define co2_sensor_type_str "SCD-41"
-#endif
+#define co2_sample_queue_len 16  // Samples waiting for the consumer, must be a power of two
+
+// I2C fault and recovery counters
+struct co2_recovery_stats_t {
+  uint32_t faults;             // Bus errors that started a recovery
+  uint32_t attempts;           // Bus reset and re-init attempts
+  uint32_t recoveries;         // Successful recoveries
+  uint32_t last_recovery_ms;   // Fault to first good restart, most recent recovery
+  uint32_t max_recovery_ms;    // Longest recovery
+  uint32_t total_recovery_ms;  // Time spent recovering since power on
+};
 
 class CO2_generic {
  public:
   // Constructor
   CO2_generic(void);
-  bool begin(void);
+  bool begin(co2_mode_t mode = co2_mode_periodic);  // Probe the I2C buses for every known sensor and start them
   bool get_co2(void);
-  int16_t calibrate(uint16_t target);
-  bool set_co2_device_settings(float t_offset, uint16_t altitude, bool asc);
-  bool get_co2_device_settings(float &t_offset, uint16_t &altitude, bool &asc);
-  void factory_reset(void);
+  // Sensor 0's settings. The write waits in get_co2() for a single shot in progress to finish, the
+  // read returns the values read back after it, or at begin(). Call with the sensor task locked out
+  void set_co2_device_settings(float t_offset, uint16_t altitude, bool asc);
+  bool get_co2_device_settings(float &t_offset, uint16_t &altitude, bool &asc) const;
+  void sim_begin(uint32_t seed, uint8_t scenario, uint16_t period_s);
   void sim_sensor(void);
+  bool recovering(void) const;
+
+  // The sensors begin() found, in co2_drivers[] order. Sensor 0 times the fused samples and is the
+  // one calibrated and configured, has() and period_ms() are for it. A feature is a co2_feature_* flag.
+  // sensors(), sensor(), name() and has() don't change after begin() and can be called from any
+  // task. period_ms(), max_period_ms(), mode() and mode_name() change while calibrating (see
+  // cal_begin()), call them with the sensor task locked out, or read them once after begin()
+  uint8_t sensors(void) const { return _n_sensors; }
+  co2_sensor_t sensor(uint8_t i = 0) const { return i < _n_sensors ? _sensors[i].type : co2_sensor_none; }
+  const char *name(uint8_t i = 0) const { return i < _n_sensors ? _sensors[i].driver->name() : "no"; }
+  bool has(uint8_t feature) const { return _n_sensors && (_sensors[0].features & feature); }
+  uint32_t period_ms(void) const;      // Shortest time between samples
+  uint32_t max_period_ms(void) const;  // Longest, more than period_ms() when sensor 0 takes single shots
+  co2_mode_t mode(void) const { return _n_sensors ? _sensors[0].mode : co2_mode_periodic; }
+  const char *mode_name(void) const;
+  void measure_now(void) { _measure_now = true; }  // Next single shot straight away, from any task
+  const char *bus_name(void) const;
+  co2_fusion_stats_t fusion_stats(uint8_t i) const { return _fusion.stats(i); }  // With the sensor task locked out
+
+  // Forced recalibration, run one step per get_co2() call so the sensor task never waits for the
+  // sensor. Samples are tagged co2_sample_flag_cal from cal_begin() until cal_end(). Call these
+  // with the sensor task locked out, cal_state() can be read at any time
+  void cal_begin(bool factory_reset);
+  void calibrate(uint16_t target);  // In cal_measuring, with the sensor in air of the target ppm
+  void cal_end(void);               // Ignored while the sensor is stopped for a step
+  co2_cal_state_t cal_state(void) const { return _cal_state; }
+  int16_t cal_correction(void) const { return _cal_correction; }  // Only valid in cal_done
+
+  // Every sample from get_co2() or sim_sensor(), oldest first. This is the only way to read the
+  // sensor values: get_co2() runs in one task (the producer), read_sample() in one other task (the consumer)
+  bool read_sample(co2_sample_t &sample) { return _samples.pop(sample); }
+  uint32_t samples_dropped(void) const { return _samples.dropped(); }
 
-// Create CO2 sensor object for the selected CO2 device
-#if defined SENSOR_IS_SCD30
-  SCD30 co2_sensor;
-#elif defined SENSOR_IS_SGP30
-  SGP30 co2_sensor;
-#elif defined SENSOR_IS_SCD41
-  SensirionI2CScd4x co2_sensor;
-#endif
-
-  uint16_t co2_level = 0;
-  float temperature = 0.0;
-  float humidity = 0.0;
   bool simulate_co2 = false;
-  bool co2_updated = false;
+  CO2_sim sim_model;  // Set up in setup(), then only used by sim_sensor()
+  co2_recovery_stats_t recovery_stats = {};
 
  private:
-  TwoWire *_wire;
+  enum recovery_state_t {
+    recovery_idle,
+    recovery_backoff,
+    recovery_bus_reset,
+    recovery_stop,
+    recovery_start,
+  };
+
+  // One sensor found by begin(), each is polled and recovered on its own
+  struct sensor_t {
+    CO2_driver *driver;
+    co2_sensor_t type;
+    uint8_t features;
+    co2_mode_t mode;
+    uint32_t period_ms;         // Sensor measurement period, or single shot measurement time
+    uint32_t next_poll_ms;      // millis() when the data ready status is next polled
+    uint32_t next_shot_ms;      // millis() when the next single shot is due
+    bool shot_pending;          // Single shot started, not read yet
+    recovery_state_t recovery_state;
+    uint32_t recovery_start_ms;
+    uint32_t recovery_due_ms;
+    uint32_t recovery_wait_ms;  // Backoff before the next attempt
+    bool single_shots(void) const { return mode == co2_mode_single_shot || mode == co2_mode_adaptive; }
+  };
+
+  uint8_t probe(bool *found);
+  template <class driver_t>
+  bool poll(driver_t &driver, uint8_t i, uint32_t now);
+  bool sampled(uint8_t i, uint32_t now, uint16_t co2_level, float temperature, float humidity);
+  bool fault(uint8_t i, uint32_t now);
+  bool fuse_due(uint8_t i, uint32_t now) const;
+  bool restart(void);
+  bool start(sensor_t &sensor);
+  void shot_done(sensor_t &sensor, uint32_t now, uint16_t co2_level);
+  void schedule_first_read(sensor_t &sensor);
+  void set_mode(sensor_t &sensor, co2_mode_t mode);
+  void recover_i2c(sensor_t &sensor, uint32_t now);
+  bool calibration_step(uint32_t now);
+  void read_settings(void);
+  void settings_step(void);
+  bool cal_busy(void) const;
+  void publish(uint16_t co2_level, float temperature, float humidity, const uint16_t *sensor_co2 = nullptr, uint16_t spread = 0);
+
+  sensor_t _sensors[co2_max_sensors] = {};
+  uint8_t _n_sensors = 0;
+  uint8_t _bus = 0;  // Index of the bus the sensors were found on
+  CO2_fusion _fusion;
+  CO2_scheduler _scheduler;  // Sensor 0 in co2_mode_adaptive
+  std::atomic<bool> _measure_now{false};
+  float _temperature = 0;  // Last reading from a sensor with co2_feature_rh_t
+  float _humidity = 0;
+  std::atomic<co2_cal_state_t> _cal_state{cal_idle};
+  uint32_t _cal_due_ms = 0;  // millis() when the next calibration step can run
+  bool _cal_reset = false;   // Factory reset before measuring
+  co2_mode_t _cal_mode = co2_mode_periodic;  // Sensor 0's configured mode, it is periodic until cal_end()
+  uint16_t _cal_target = 0;
+  int16_t _cal_correction = 0;
+  struct settings_t {
+    float t_offset;
+    uint16_t altitude;
+    bool asc;
+  };
+  settings_t _settings = {};      // As last read from sensor 0
+  bool _settings_ok = false;      // _settings was read without error
+  settings_t _new_settings = {};  // Waiting to be written while _settings_due
+  std::atomic<bool> _settings_due{false};
+  co2_sample_t _last = {};  // Last sample published
+  SPSC_queue<co2_sample_t, co2_sample_queue_len> _samples;
 };
\ No newline at end of file
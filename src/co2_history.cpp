@@ -0,0 +1,281 @@
+//
+//    FILE: co2_history.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Integer CO2 history with raw, minute and hour tiers
+//
+//
+//  HISTORY:
+//  0.0.1   2026-10-16  initial version, replaces three float RunningAverage buffers
+//  0.0.2   2026-10-17  bucketing by sample timestamp, with explicit gaps
+//  0.0.3   2026-10-17  time weighted averages for variable sample intervals
+//
+
+#include "co2_history.h"
+
+#include <algorithm>
+
+/////////////////////////////////////////////////////
+//
+// SLIDING WINDOW
+//
+CO2_window::CO2_window(uint16_t size) {
+  _size = size;
+  _vals = new uint16_t[size];
+  _min_q.buf = new entry_t[size];
+  _max_q.buf = new entry_t[size];
+}
+
+CO2_window::~CO2_window(void) {
+  delete[] _vals;
+  delete[] _min_q.buf;
+  delete[] _max_q.buf;
+}
+
+void CO2_window::add(uint16_t ppm) {
+  _seq++;
+
+  // Running sum of the last "size" samples, gaps are not counted
+  if (_count == _size) {
+    if (_vals[_pos] != co2_gap) {
+      _sum -= _vals[_pos];
+      _valid--;
+    }
+  } else
+    _count++;
+  _vals[_pos] = ppm;
+  if (ppm != co2_gap) {
+    _sum += ppm;
+    _valid++;
+  }
+  _pos = (_pos + 1) % _size;
+
+  push(_min_q, ppm, true);
+  push(_max_q, ppm, false);
+}
+
+// Front of the queue is the current min (or max). Samples that can never become the min (max)
+// again are dropped from the back, so each sample is pushed and popped at most once
+void CO2_window::push(queue_t &q, uint16_t ppm, bool keep_min) {
+  // Only one sample leaves the window per add, and it can only be at the front
+  if (q.len && q.front().seq + _size <= _seq) {
+    q.head = (q.head + 1) % _size;
+    q.len--;
+  }
+  if (ppm == co2_gap) return;
+
+  while (q.len) {
+    uint16_t back = q.buf[(q.head + q.len - 1) % _size].ppm;
+    if (keep_min ? back < ppm : back > ppm) break;
+    q.len--;
+  }
+
+  q.buf[(q.head + q.len) % _size] = {_seq, ppm};
+  q.len++;
+}
+
+void CO2_window::clear(void) {
+  _pos = 0;
+  _count = 0;
+  _valid = 0;
+  _sum = 0;
+  _min_q.head = _min_q.len = 0;
+  _max_q.head = _max_q.len = 0;
+}
+
+/////////////////////////////////////////////////////
+//
+// RING BUFFER
+//
+CO2_ring::CO2_ring(uint16_t size, uint16_t window_size) {
+  _size = size;
+  if (window_size > 0) _window = new CO2_window(window_size);
+}
+
+CO2_ring::~CO2_ring(void) {
+  delete[] _buf;
+  delete _window;
+}
+
+void CO2_ring::add(uint16_t ppm) {
+  if (!_buf) _buf = new uint16_t[_size];
+  if (_count == _size) {
+    // Full, overwrite the oldest sample
+    if (_buf[_head] != co2_gap) {
+      _sum -= _buf[_head];
+      _valid--;
+    }
+    _buf[_head] = ppm;
+    _head = (_head + 1) % _size;
+  } else {
+    _buf[(_head + _count) % _size] = ppm;
+    _count++;
+  }
+  if (ppm != co2_gap) {
+    _sum += ppm;
+    _valid++;
+  }
+  if (_window) _window->add(ppm);
+  _version++;
+}
+
+// More gaps than the ring holds would only overwrite each other
+void CO2_ring::add_gaps(uint32_t n) {
+  for (n = std::min(n, (uint32_t)_size); n > 0; n--)
+    add(co2_gap);
+}
+
+void CO2_ring::clear(void) {
+  _head = 0;
+  _count = 0;
+  _valid = 0;
+  _sum = 0;
+  if (_window) _window->clear();
+  _version++;
+}
+
+void CO2_ring::resize(uint16_t size) {
+  clear();
+  if (size == _size) return;
+  delete[] _buf;
+  _buf = nullptr;
+  _size = size;
+}
+
+uint16_t CO2_ring::get(uint16_t i) const {
+  if (i >= _count) return 0;
+  return _buf[(_head + i) % _size];
+}
+
+uint16_t CO2_ring::average(void) const {
+  return _valid ? (uint16_t)((_sum + _valid / 2) / _valid) : 0;
+}
+
+// The following scan the last n samples, skipping gaps, use the window_*() functions on the display path
+uint16_t CO2_ring::average_last(uint16_t n) const {
+  if (n > _count) n = _count;
+  uint32_t sum = 0;
+  uint16_t valid = 0;
+  for (uint16_t i = _count - n; i < _count; i++) {
+    if (get(i) == co2_gap) continue;
+    sum += get(i);
+    valid++;
+  }
+  return valid ? (uint16_t)((sum + valid / 2) / valid) : 0;
+}
+
+uint16_t CO2_ring::min_last(uint16_t n) const {
+  if (n > _count) n = _count;
+  uint16_t min = UINT16_MAX;
+  for (uint16_t i = _count - n; i < _count; i++)
+    if (get(i) != co2_gap && get(i) < min) min = get(i);
+  return min == UINT16_MAX ? 0 : min;
+}
+
+uint16_t CO2_ring::max_last(uint16_t n) const {
+  if (n > _count) n = _count;
+  uint16_t max = 0;
+  for (uint16_t i = _count - n; i < _count; i++)
+    if (get(i) > max) max = get(i);
+  return max;
+}
+
+/////////////////////////////////////////////////////
+//
+// BUCKET
+//
+void CO2_bucket::add(uint16_t ppm, uint16_t weight_s) {
+  sum += (uint32_t)ppm * weight_s;
+  weight += weight_s;
+  count++;
+  if (ppm < min) min = ppm;
+  if (ppm > max) max = ppm;
+}
+
+/////////////////////////////////////////////////////
+//
+// HISTORY TIERS
+//
+CO2_history::CO2_history(uint16_t raw_s, uint16_t raw_disp_pts, uint16_t raw_period_s,
+                         uint16_t minute_pts, uint16_t minute_disp_pts,
+                         uint16_t hour_pts, uint16_t hour_disp_pts)
+    : raw(raw_s / raw_period_s, raw_disp_pts), minute(minute_pts, minute_disp_pts), hour(hour_pts, hour_disp_pts) {
+  _raw_s = raw_s;
+  set_raw_period(raw_period_s);
+}
+
+// The raw ring keeps the same time at the new period, before the first sample it is not allocated yet
+
+void CO2_history::set_raw_period(uint16_t raw_period_s, uint16_t max_interval_s) {
+  if (raw_period_s != _raw_period_s) raw.resize(_raw_s / raw_period_s);
+  _raw_period_s = raw_period_s;
+  _max_interval_s = max_interval_s > raw_period_s ? max_interval_s : raw_period_s;
+}
+
+void CO2_history::add(uint32_t t, uint16_t ppm) {
+  if (!_started) {
+    _started = true;
+    _minute_idx = t / 60;
+    _hour_idx = t / 3600;
+    _last_raw_t = t;
+  }
+  advance(t);
+  if (ppm == co2_gap) {
+    _last_ppm = co2_gap;  // Becomes a raw gap when the next good sample arrives, nothing is held
+    return;
+  }
+
+  // Raw samples missed since the last one, e.g. the sensor dropped off the I2C bus. A single late
+  // or missing sample is not marked, the interval between samples jitters by a second or so
+  if (t > _last_raw_t + 2 * _max_interval_s) raw.add_gaps((t - _last_raw_t) / _max_interval_s - 1);
+  raw.add(ppm);
+
+  // Weighted by the time since the last sample, a gap only counts up to the longest interval
+  uint32_t weight = t - _last_raw_t;
+  if (weight < _raw_period_s) weight = _raw_period_s;
+  if (weight > _max_interval_s) weight = _max_interval_s;
+  _last_raw_t = t;
+  _last_ppm = ppm;
+
+  _minute_bucket.add(ppm, weight);
+  _hour_bucket.add(ppm, weight);
+}
+
+// Called every second or so, closes minutes and hours on time even when no samples arrive
+void CO2_history::advance(uint32_t t) {
+  if (!_started) return;  // Nothing to close before the first sample
+  roll(minute, _minute_bucket, _minute_idx, t / 60, 60);
+  roll(hour, _hour_bucket, _hour_idx, t / 3600, 3600);
+}
+
+// Store the average of the bucket for "period", then each whole period between it and now_period.
+// A period without samples is a gap (e.g. while the power was off), or holds the last sample if
+// the sample interval varies and it started within the longest interval of that sample
+void CO2_history::roll(CO2_ring &ring, CO2_bucket &bucket, uint32_t &period, uint32_t now_period, uint32_t period_s) {
+  if (now_period <= period) return;  // Still in the same period
+  uint32_t held_until = 0;           // First period the last sample doesn't cover
+  if (_max_interval_s > _raw_period_s && _last_ppm != co2_gap)
+    held_until = (_last_raw_t + _max_interval_s + period_s - 1) / period_s;
+
+  if (bucket.count)
+    ring.add(bucket.average());
+  else if (period < held_until)
+    ring.add(_last_ppm);
+  else
+    ring.add_gaps(1);
+  bucket.clear();
+  for (period++; period < now_period && period < held_until; period++) ring.add(_last_ppm);
+  if (period < now_period) ring.add_gaps(now_period - period);
+  period = now_period;
+}
+
+void CO2_history::clear(void) {
+  raw.clear();
+  minute.clear();
+  hour.clear();
+  _minute_bucket.clear();
+  _hour_bucket.clear();
+  _last_ppm = co2_gap;
+  _started = false;
+}
@@ -0,0 +1,156 @@
+#pragma once
+//
+//    FILE: co2_history.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Integer CO2 history with raw, minute and hour tiers
+//
+// Samples are stored as uint16_t ppm. Each ring keeps a running integer sum so the average of the
+// whole ring is O(1), and the minute and hour tiers are fed from running buckets, so a rollup
+// never re-scans the raw samples. Averages are rounded to the nearest ppm.
+//
+// Bucketing is driven by the sample timestamps, not by when the code happens to run. A sample at
+// time t goes into minute t / 60 and hour t / 3600; the first sample of a new minute (or an
+// advance() past the end of it) closes the old one. A minute, hour or run of raw samples with no
+// valid readings is stored as co2_gap, so each bar on the display is always one period of time
+// and the min, max and average ignore the gaps.
+//
+// The sample interval can vary (an SCD-41 taking adaptive single shots, 5 s to 5 minutes apart),
+// so the minute and hour averages are weighted by the time each sample stands for, the time since
+// the one before, from raw_period_s up to max_interval_s. Ten samples 5 s apart during a spike
+// then count for 50 s, not ten times a sample that stood for 5 minutes of flat air. A minute with
+// no sample that starts within max_interval_s of the last one is not a gap, it holds that sample,
+// as the display does. At a fixed interval every weight is the same, the averages are plain means
+// and an empty minute is a gap. A raw bar is one sample.
+//
+
+#include "Arduino.h"
+
+#define co2_gap 0  // Stored for a sample, minute or hour with no valid reading
+
+// Min, max and average of the last "size" samples, updated in O(1) (amortised) per sample.
+// Min and max use monotonic queues of (sequence number, ppm) so reading them is O(1).
+// Gaps take a place in the window but are left out of the min, max and average.
+class CO2_window {
+ public:
+  CO2_window(uint16_t size);
+  ~CO2_window(void);
+  CO2_window(const CO2_window &) = delete;  // Owns its buffers
+  CO2_window &operator=(const CO2_window &) = delete;
+  void add(uint16_t ppm);
+  void clear(void);
+  uint16_t min(void) const { return _min_q.len ? _min_q.front().ppm : 0; }
+  uint16_t max(void) const { return _max_q.len ? _max_q.front().ppm : 0; }
+  uint16_t average(void) const { return _valid ? (uint16_t)((_sum + _valid / 2) / _valid) : 0; }
+  uint16_t count(void) const { return _count; }
+
+ private:
+  struct entry_t {
+    uint32_t seq;
+    uint16_t ppm;
+  };
+
+  // Fixed capacity double ended queue
+  struct queue_t {
+    entry_t *buf;
+    uint16_t head;
+    uint16_t len;
+    const entry_t &front(void) const { return buf[head]; }
+  };
+
+  void push(queue_t &q, uint16_t ppm, bool keep_min);
+
+  uint16_t _size;
+  uint16_t *_vals;  // Last "size" samples, to subtract the one leaving the window from the sum
+  uint16_t _pos = 0;
+  uint16_t _count = 0;
+  uint16_t _valid = 0;  // Samples in the window that are not gaps
+  uint32_t _sum = 0;
+  uint32_t _seq = 0;
+  queue_t _min_q = {};
+  queue_t _max_q = {};
+};
+
+// Circular buffer of ppm samples, same mental model as RunningAverage:
+//   get(count() - 1) is the last value added
+//   get(0) is the oldest value still in the buffer
+//
+// The optional window tracks the last window_size samples (the bars on the display). The buffer
+// is allocated by the first add(), so a resize() before then costs nothing
+class CO2_ring {
+ public:
+  CO2_ring(uint16_t size, uint16_t window_size = 0);
+  ~CO2_ring(void);
+  CO2_ring(const CO2_ring &) = delete;  // Owns _buf and _window
+  CO2_ring &operator=(const CO2_ring &) = delete;
+  void add(uint16_t ppm);
+  void add_gaps(uint32_t n);
+  void clear(void);
+  void resize(uint16_t size);  // Clears the samples
+  uint16_t get(uint16_t i) const;
+  uint16_t count(void) const { return _count; }
+  uint16_t size(void) const { return _size; }
+  uint16_t average(void) const;
+  uint16_t average_last(uint16_t n) const;
+  uint16_t min_last(uint16_t n) const;
+  uint16_t max_last(uint16_t n) const;
+  uint16_t window_min(void) const { return _window ? _window->min() : 0; }
+  uint16_t window_max(void) const { return _window ? _window->max() : 0; }
+  uint16_t window_average(void) const { return _window ? _window->average() : 0; }
+  uint32_t version(void) const { return _version; }  // Changes on every add() or clear(), lets the display skip redraws
+
+ private:
+  CO2_window *_window = nullptr;
+  uint16_t *_buf = nullptr;
+  uint16_t _size;
+  uint16_t _head = 0;  // Index of the oldest sample
+  uint16_t _count = 0;
+  uint16_t _valid = 0;  // Samples that are not gaps
+  uint32_t _sum = 0;
+  uint32_t _version = 0;
+};
+
+// Running time weighted sum, min and max of the samples in one minute or hour
+struct CO2_bucket {
+  uint32_t sum = 0;     // ppm x seconds
+  uint32_t weight = 0;  // Seconds
+  uint16_t count = 0;
+  uint16_t min = UINT16_MAX;
+  uint16_t max = 0;
+
+  void add(uint16_t ppm, uint16_t weight_s);
+  void clear(void) { *this = CO2_bucket(); }
+  uint16_t average(void) const { return weight ? (uint16_t)((sum + weight / 2) / weight) : 0; }
+};
+
+// Times are seconds on a clock that never goes backwards. A sample older than the current
+// minute or hour is counted in the current one.
+class CO2_history {
+ public:
+  CO2_history(uint16_t raw_s, uint16_t raw_disp_pts, uint16_t raw_period_s,
+              uint16_t minute_pts, uint16_t minute_disp_pts,
+              uint16_t hour_pts, uint16_t hour_disp_pts);
+  void add(uint32_t t, uint16_t ppm);  // A ppm of co2_gap (failed read) is left out of the buckets
+  void advance(uint32_t t);            // Close every minute and hour that ended before t
+  void clear(void);
+  void set_raw_period(uint16_t raw_period_s, uint16_t max_interval_s = 0);  // Sensor found at power up, 0 = fixed interval
+
+  CO2_ring raw;     // Raw sensor samples, raw_s seconds of them at raw_period_s
+  CO2_ring minute;  // 1 minute averages
+  CO2_ring hour;    // 1 hour averages
+
+ private:
+  void roll(CO2_ring &ring, CO2_bucket &bucket, uint32_t &period, uint32_t now_period, uint32_t period_s);
+
+  uint16_t _raw_s;             // Time the raw ring holds at the shortest interval
+  uint16_t _raw_period_s = 0;  // Sensor sample interval, the shortest if it varies
+  uint16_t _max_interval_s;    // Longest sample interval, a longer one is a gap
+  bool _started = false;       // Clock starts at the first sample
+  uint32_t _last_raw_t = 0;    // Time of the last valid raw sample
+  uint16_t _last_ppm = co2_gap;
+  uint32_t _minute_idx = 0;    // Minute the bucket is collecting, t / 60
+  uint32_t _hour_idx = 0;      // Hour the bucket is collecting, t / 3600
+  CO2_bucket _minute_bucket;   // Samples in the current minute
+  CO2_bucket _hour_bucket;     // Samples in the current hour
+};
@@ -0,0 +1,175 @@
+//
+//    FILE: co2_log.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: CO2 history saved to the SD card in a binary ring file, restored at boot
+//
+//
+//  HISTORY:
+//  0.0.1   2026-10-16  initial version
+//
+
+#include "co2_log.h"
+
+#include <algorithm>
+
+// Seconds since 2000-01-01 00:00:00 without any time zone conversion, so minute and hour
+// boundaries line up with the RTC
+uint32_t co2_log_time(int16_t year, int8_t month, int8_t day, int8_t hours, int8_t minutes, int8_t seconds) {
+  // Days from the civil calendar date, years start in March so the leap day is last
+  int32_t y = year - (month <= 2);
+  int32_t era = (y >= 0 ? y : y - 399) / 400;
+  int32_t yoe = y - era * 400;
+  int32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  int32_t days = era * 146097 + doe - 730425;  // 730425 = days from 0000-03-01 to 2000-01-01
+
+  return (uint32_t)days * 86400 + hours * 3600 + minutes * 60 + seconds;
+}
+
+CO2_log::CO2_log(uint32_t capacity) {
+  set_capacity(capacity);
+}
+
+void CO2_log::set_capacity(uint32_t capacity) {
+  // Whole number of batches, so every batch is one aligned sector and never wraps
+  _hdr.capacity = (capacity + co2_log_batch - 1) / co2_log_batch * co2_log_batch;
+}
+
+/////////////////////////////////////////////////////
+//
+// OPEN
+//
+bool CO2_log::begin(fs::FS &fs, const char *path) {
+  uint32_t capacity = _hdr.capacity;
+  co2_log_hdr_t hdr = {};
+
+  _ok = false;
+  if (fs.exists(path)) _file = fs.open(path, "r+");
+  if (_file && _file.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+      hdr.magic == co2_log_magic && hdr.version == co2_log_version && hdr.rec_size == sizeof(co2_log_rec_t) &&
+      hdr.capacity == capacity && hdr.head < capacity && hdr.count <= capacity) {
+    _hdr = hdr;
+    _ok = true;
+    return true;
+  }
+
+  // Missing, from another firmware version or a different capacity, start again
+  _file.close();
+  return create(fs, path);
+}
+
+bool CO2_log::create(fs::FS &fs, const char *path) {
+  uint8_t sector[co2_log_hdr_size] = {};
+
+  _hdr = {co2_log_magic, co2_log_version, sizeof(co2_log_rec_t), _hdr.capacity, 0, 0, 0};
+  memcpy(sector, &_hdr, sizeof(_hdr));
+  _file = fs.open(path, FILE_WRITE, true);
+  if (!_file || _file.write(sector, sizeof(sector)) != sizeof(sector)) {
+    _file.close();
+    return false;
+  }
+  _file.close();
+  _file = fs.open(path, "r+");
+  _ok = (bool)_file;
+  return _ok;
+}
+
+bool CO2_log::write_header(void) {
+  return _file.seek(0) && _file.write((const uint8_t *)&_hdr, sizeof(_hdr)) == sizeof(_hdr);
+}
+
+uint8_t CO2_log::check_byte(const co2_log_rec_t &rec) {
+  const uint8_t *p = (const uint8_t *)&rec;
+  uint8_t check = 0x5A;  // Non zero so an erased (all zero) record fails
+  for (size_t i = 0; i < sizeof(rec) - 1; i++)
+    check ^= p[i];
+  return check;
+}
+
+/////////////////////////////////////////////////////
+//
+// WRITE
+//
+void CO2_log::add(uint32_t time, uint16_t ppm, float temp, float humid, uint8_t flags) {
+  if (!_ok) return;
+
+  co2_log_rec_t &rec = _batch[_batch_len++];
+  rec.seq = _hdr.next_seq++;
+  rec.time = time;
+  rec.ppm = ppm;
+  rec.temp_c100 = isnan(temp) ? 0 : (int16_t)lroundf(temp * 100.0f);
+  rec.humid_c100 = isnan(humid) ? 0 : (uint16_t)lroundf(humid * 100.0f);
+  rec.flags = flags | (_first ? co2_log_flag_boot : 0);
+  rec.check = check_byte(rec);
+  _first = false;
+
+  if (_batch_len == co2_log_batch) flush();
+}
+
+// Records first, then the header, so a power cut between the two loses the batch but never
+// leaves the header pointing at records that were not written
+bool CO2_log::flush(void) {
+  if (!_ok || _batch_len == 0) return _ok;
+
+  size_t bytes = _batch_len * sizeof(co2_log_rec_t);
+  bool write_ok = _file.seek(co2_log_hdr_size + _hdr.head * sizeof(co2_log_rec_t)) &&
+                  _file.write((const uint8_t *)_batch, bytes) == bytes;
+  if (write_ok) {
+    _hdr.head = (_hdr.head + _batch_len) % _hdr.capacity;
+    _hdr.count = std::min(_hdr.count + _batch_len, _hdr.capacity);
+    write_ok = write_header();
+    _file.flush();
+  }
+  _batch_len = 0;
+
+  // Card removed or full, stop logging rather than retry every sample
+  if (!write_ok) {
+    Serial.println("Error writing CO2 history to SD card, logging stopped");
+    _ok = false;
+    _file.close();
+  }
+  return write_ok;
+}
+
+/////////////////////////////////////////////////////
+//
+// RESTORE
+//
+// Replay the saved samples through the same path as live samples (CO2_history::add() with the
+// saved timestamp), so all three tiers and the partly filled minute and hour buckets come back
+// as they were.
+uint32_t CO2_log::restore(CO2_history &hist, uint32_t now, uint32_t max_age_s) {
+  co2_log_rec_t recs[co2_log_batch];
+  uint32_t restored = 0;
+  uint32_t prev_seq = 0;
+
+  if (!_ok || _hdr.count == 0) return 0;
+
+  uint32_t slot = (_hdr.head + _hdr.capacity - _hdr.count) % _hdr.capacity;
+  for (uint32_t done = 0; done < _hdr.count;) {
+    // Read up to a batch, stopping at the end of the file
+    uint32_t n = std::min(std::min((uint32_t)co2_log_batch, _hdr.count - done), _hdr.capacity - slot);
+    if (!_file.seek(co2_log_hdr_size + slot * sizeof(co2_log_rec_t)) ||
+        _file.read((uint8_t *)recs, n * sizeof(co2_log_rec_t)) != n * sizeof(co2_log_rec_t))
+      break;
+
+    for (uint32_t i = 0; i < n; i++) {
+      const co2_log_rec_t &rec = recs[i];
+      if (rec.check != check_byte(rec) || (restored && rec.seq <= prev_seq)) continue;
+      if (rec.time + max_age_s < now || rec.time > now) continue;  // Too old, or RTC was wrong when saved
+
+      hist.add(rec.time, rec.ppm);
+      prev_seq = rec.seq;
+      restored++;
+    }
+    done += n;
+    slot = (slot + n) % _hdr.capacity;
+  }
+
+  // Close off buckets whose minute or hour ended while the power was off, the time without
+  // power shows as gaps
+  hist.advance(now);
+  return restored;
+}
@@ -0,0 +1,79 @@
+#pragma once
+//
+//    FILE: co2_log.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: CO2 history saved to the SD card in a binary ring file, restored at boot
+//
+// File layout:
+//   Bytes 0..511   Header (co2_log_hdr_t, zero padded to one sector)
+//   Bytes 512..    capacity fixed size records (co2_log_rec_t), used as a circular buffer
+//
+// Records are batched in RAM and written one whole sector at a time, followed by the header,
+// so the card sees two sector writes every co2_log_batch samples instead of one per sample.
+// Up to one batch of samples is lost if power is removed.
+//
+
+#include <FS.h>
+
+#include "Arduino.h"
+#include "co2_history.h"
+
+#define co2_log_magic    0x4C324F43  // "CO2L"
+#define co2_log_version  1
+#define co2_log_hdr_size 512  // Header occupies the first sector of the file
+#define co2_log_batch    32   // Records per write, 32 x 16 bytes = one 512 byte sector
+
+// Record flags
+#define co2_log_flag_boot    0x01  // First record after power up, there may be a gap before it
+#define co2_log_flag_no_rh_t 0x02  // Sensor has no temperature or humidity (SGP-30)
+#define co2_log_flag_cal     0x04  // Read during a forced recalibration
+
+struct co2_log_rec_t {
+  uint32_t seq;         // Record number, never wraps in the lifetime of the card
+  uint32_t time;        // Seconds since 2000-01-01 00:00:00 RTC (local) time, see co2_log_time()
+  uint16_t ppm;         // CO2
+  int16_t temp_c100;    // Temperature in 0.01 C
+  uint16_t humid_c100;  // Relative humidity in 0.01 %
+  uint8_t flags;        // co2_log_flag_*
+  uint8_t check;        // XOR of the other 15 bytes, detects a torn sector write
+};
+static_assert(sizeof(co2_log_rec_t) == 16, "co2_log_rec_t must pack into 16 bytes");
+
+struct co2_log_hdr_t {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t rec_size;
+  uint32_t capacity;  // Records
+  uint32_t head;      // Slot the next record is written to
+  uint32_t count;     // Records in the file, up to capacity
+  uint32_t next_seq;
+};
+
+uint32_t co2_log_time(int16_t year, int8_t month, int8_t day, int8_t hours, int8_t minutes, int8_t seconds);
+
+class CO2_log {
+ public:
+  CO2_log(uint32_t capacity);
+  void set_capacity(uint32_t capacity);  // Before begin(), a file of another capacity is started again
+  bool begin(fs::FS &fs, const char *path);
+  void add(uint32_t time, uint16_t ppm, float temp, float humid, uint8_t flags = 0);
+  bool flush(void);
+  uint32_t restore(CO2_history &hist, uint32_t now, uint32_t max_age_s);
+  bool ok(void) const { return _ok; }
+  uint32_t count(void) const { return _hdr.count; }  // Records on the card, excluding the batch in RAM
+  uint32_t capacity(void) const { return _hdr.capacity; }
+  static uint8_t check_byte(const co2_log_rec_t &rec);
+
+ private:
+  bool create(fs::FS &fs, const char *path);
+  bool write_header(void);
+
+  fs::File _file;
+  co2_log_hdr_t _hdr = {};
+  co2_log_rec_t _batch[co2_log_batch];
+  uint8_t _batch_len = 0;
+  bool _ok = false;
+  bool _first = true;
+};
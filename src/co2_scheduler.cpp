@@ -0,0 +1,37 @@
+//
+//    FILE: co2_scheduler.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: Picks the time to the next single shot CO2 measurement from how the reading is moving
+//
+//
+//  HISTORY:
+//  0.0.1   2026-10-17  initial version, adaptive SCD-41 single shot interval
+//
+
+#include "co2_scheduler.h"
+
+#include <stdlib.h>
+
+void CO2_scheduler::clear(void) {
+  _last_ppm = 0;
+  _interval_ms = co2_adapt_min_ms;
+}
+
+uint32_t CO2_scheduler::next_interval_ms(uint16_t ppm) {
+  if (!ppm) {
+    _interval_ms = co2_adapt_min_ms;  // Failed read, try again soon
+    return _interval_ms;
+  }
+
+  int change = abs((int)ppm - (int)_last_ppm);
+  if (!_last_ppm || change >= co2_adapt_change_ppm)
+    _interval_ms = co2_adapt_min_ms;
+  else if (change < co2_adapt_flat_ppm)
+    _interval_ms = _interval_ms * 2 > co2_adapt_max_ms ? co2_adapt_max_ms : _interval_ms * 2;
+
+  if (ppm >= co2_adapt_high_ppm && _interval_ms > co2_adapt_high_max_ms) _interval_ms = co2_adapt_high_max_ms;
+  _last_ppm = ppm;
+  return _interval_ms;
+}
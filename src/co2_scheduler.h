@@ -0,0 +1,39 @@
+#pragma once
+//
+//    FILE: co2_scheduler.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: Picks the time to the next single shot CO2 measurement from how the reading is moving
+//
+// An SCD-41 taking a single shot every 5 minutes uses a few percent of the power of periodic
+// measurement, but would miss a room filling up. After each sample the interval is set from the
+// change since the last one: a change well above the sensor's noise (someone came in, a window was
+// opened) drops straight back to back-to-back shots, a change inside the noise doubles the
+// interval, up to co2_adapt_max_ms, and anything between keeps it. Above co2_adapt_high_ppm the
+// interval is held at co2_adapt_high_max_ms or less, so the display and LEDs keep up while the air
+// needs attention, even if it is flat.
+//
+// The SCD-41's ASC (automatic self calibration) assumes a sample every 5 minutes in single shot
+// mode, co2_adapt_max_ms, so its standard period is about right when the air is flat.
+//
+
+#include <stdint.h>
+
+#define co2_adapt_min_ms      5000    // Back to back single shots, as often as periodic measurement
+#define co2_adapt_max_ms      300000  // Flat air, one shot every 5 minutes
+#define co2_adapt_high_ppm    1000    // LEDs go yellow
+#define co2_adapt_high_max_ms 30000   // Longest interval above co2_adapt_high_ppm
+#define co2_adapt_change_ppm  30      // Changing, about 3x the SCD-41 repeatability
+#define co2_adapt_flat_ppm    15      // Flat, inside the noise of two samples
+
+class CO2_scheduler {
+ public:
+  void clear(void);
+  uint32_t next_interval_ms(uint16_t ppm);  // After each sample, 0 = failed read
+  uint32_t interval_ms(void) const { return _interval_ms; }
+
+ private:
+  uint16_t _last_ppm = 0;
+  uint32_t _interval_ms = co2_adapt_min_ms;
+};
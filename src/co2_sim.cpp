@@ -0,0 +1,250 @@
+//
+//    FILE: co2_sim.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: Repeatable CO2 sensor simulation, scripted room scenarios or a replayed trace
+//
+//
+//  HISTORY:
+//  0.0.1   2026-10-17  initial version, replaces the random sawtooth in CO2_generic::sim_sensor()
+//
+
+#include "co2_sim.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "co2_log.h"
+
+#define co2_sim_gen_ppm_m3 5.0    // CO2 breathed out per person, 0.005 l/s = 5 ppm/s in 1 m3 of air
+#define co2_sim_drift_s    900.0  // Time constant of the temperature and humidity drift
+
+/////////////////////////////////////////////////////
+//
+// SCENARIOS
+//
+// Office, 6 x 5 x 2.7 m. A meeting fills it, the windows are opened, then the sensor cable is
+// knocked out and the bus glitches later in the afternoon
+static const co2_sim_step_t office_steps[] = {
+    {1800, 0, 0.5, sim_event_none},     // Empty, outdoor level
+    {900, 4, 0.5, sim_event_none},      // People arrive
+    {3600, 4, 0.5, sim_event_none},     // Working, windows shut
+    {600, 10, 0.5, sim_event_none},     // Meeting
+    {2700, 10, 0.5, sim_event_none},
+    {900, 10, 6.0, sim_event_none},     // Windows opened
+    {600, 2, 1.0, sim_event_none},      // Meeting ends
+    {60, 2, 1.0, sim_event_dropout},    // Sensor unplugged
+    {1800, 2, 1.0, sim_event_none},
+    {30, 2, 1.0, sim_event_i2c_error},  // Bus errors
+    {3600, 0, 0.5, sim_event_none},     // Everyone gone, slow decay
+};
+
+// Classroom, 10 x 7 x 2.6 m, 50 minute lessons with the windows opened at the break
+static const co2_sim_step_t classroom_steps[] = {
+    {300, 25, 0.7, sim_event_none},  // Class comes in
+    {2700, 25, 0.7, sim_event_none},
+    {120, 0, 0.7, sim_event_none},   // Break
+    {480, 0, 8.0, sim_event_none},   // Windows opened
+};
+
+// Small room with a flaky sensor, for the history gap handling
+static const co2_sim_step_t faults_steps[] = {
+    {600, 2, 0.5, sim_event_none},
+    {5, 2, 0.5, sim_event_dropout},    // One missed sample, not a gap in the history
+    {300, 2, 0.5, sim_event_none},
+    {90, 2, 0.5, sim_event_dropout},
+    {300, 3, 0.5, sim_event_none},
+    {20, 3, 0.5, sim_event_i2c_error},
+    {400, 3, 0.5, sim_event_none},
+    {600, 0, 0.5, sim_event_dropout},  // Sensor off for 10 minutes
+};
+
+#define steps_of(s) s, sizeof(s) / sizeof(s[0])
+
+const co2_sim_scenario_t co2_sim_scenarios[] = {
+    {"office", 81.0, steps_of(office_steps)},
+    {"classroom", 182.0, steps_of(classroom_steps)},
+    {"faults", 30.0, steps_of(faults_steps)},
+};
+const uint8_t co2_sim_n_scenarios = sizeof(co2_sim_scenarios) / sizeof(co2_sim_scenarios[0]);
+
+/////////////////////////////////////////////////////
+//
+// SIMULATION
+//
+CO2_sim::~CO2_sim(void) {
+  delete[] _trace;
+}
+
+void CO2_sim::begin(uint32_t seed, uint8_t scenario, uint16_t period_s) {
+  _scenario = &co2_sim_scenarios[scenario < co2_sim_n_scenarios ? scenario : 0];
+  _rng = seed ? seed : 1;  // xorshift never leaves 0
+  _period_s = period_s;
+  _step = 0;
+  _step_t = 0;
+  _from_occupants = 0;
+  _co2 = co2_sim_outdoor_ppm;
+  _temp = 19.5;
+  _humid = 40.0;
+  _trace_pos = _trace_len;  // Any trace starts again from the beginning
+}
+
+bool CO2_sim::next(uint16_t &co2_level, float &temperature, float &humidity) {
+  if (_trace_len) return next_trace(co2_level, temperature, humidity);
+  return next_scenario(co2_level, temperature, humidity);
+}
+
+bool CO2_sim::next_scenario(uint16_t &co2_level, float &temperature, float &humidity) {
+  const co2_sim_step_t &step = _scenario->steps[_step];
+  float occupants = _from_occupants + (step.occupants - _from_occupants) * _step_t / step.duration_s;
+
+  // People add CO2, ventilation swaps room air for outdoor air
+  _co2 += _period_s * (occupants * co2_sim_gen_ppm_m3 / _scenario->volume_m3 -
+                       step.ach / 3600.0 * (_co2 - co2_sim_outdoor_ppm));
+
+  // Warmer and more humid with more people in the room, drier with the windows open
+  float k = _period_s / co2_sim_drift_s;
+  _temp += k * (19.5 + occupants * 20.0 / _scenario->volume_m3 - _temp);
+  _humid += k * (40.0 + occupants * 40.0 / _scenario->volume_m3 - step.ach - _humid);
+
+  // Noise is drawn for every sample, so an event doesn't change the samples after it
+  co2_level = std::max((int32_t)_co2 + noise(co2_sim_noise_ppm), (int32_t)1);
+  temperature = _temp + noise(5) / 100.0;
+  humidity = _humid + noise(20) / 100.0;
+  if (step.event == sim_event_i2c_error) co2_level = 0;
+  bool sampled = step.event != sim_event_dropout;
+
+  _step_t += _period_s;
+  if (_step_t >= step.duration_s) {
+    _from_occupants = step.occupants;
+    _step = (_step + 1) % _scenario->n_steps;
+    _step_t = 0;
+  }
+  return sampled;
+}
+
+// -range to +range, xorshift32
+int32_t CO2_sim::noise(int32_t range) {
+  _rng ^= _rng << 13;
+  _rng ^= _rng >> 17;
+  _rng ^= _rng << 5;
+  return (int32_t)(_rng % (2 * range + 1)) - range;
+}
+
+/////////////////////////////////////////////////////
+//
+// TRACE REPLAY
+//
+bool CO2_sim::next_trace(uint16_t &co2_level, float &temperature, float &humidity) {
+  if (_trace_pos == _trace_len) {  // Start again from the beginning
+    _trace_pos = 0;
+    _trace_t = _trace[0].time_s;
+  }
+
+  // Latest sample due, a trace with more than one sample per period is thinned out
+  const co2_sim_sample_t *sample = nullptr;
+  while (_trace_pos < _trace_len && _trace[_trace_pos].time_s <= _trace_t)
+    sample = &_trace[_trace_pos++];
+  _trace_t += _period_s;
+
+  if (!sample) {
+    // Between trace samples, hold the last one unless the trace has a gap here
+    sample = &_trace[_trace_pos - 1];
+    if (_trace[_trace_pos].time_s - sample->time_s > co2_sim_hold_s) return false;
+  }
+  co2_level = sample->co2_level;
+  temperature = sample->temp_c100 / 100.0;
+  humidity = sample->humid_c100 / 100.0;
+  return true;
+}
+
+// False when the trace is full
+bool CO2_sim::add_trace(const co2_sim_sample_t &sample) {
+  if (!_trace) _trace = new co2_sim_sample_t[co2_sim_trace_max];
+  if (_trace_len == co2_sim_trace_max) return false;
+  if (_trace_len && sample.time_s < _trace[_trace_len - 1].time_s) return true;  // Out of order, skipped
+  _trace[_trace_len++] = sample;
+  _trace_pos = _trace_len;
+  return true;
+}
+
+// "seconds,co2,temperature,humidity", false for a header, comment or blank line
+static bool parse_csv_line(const char *line, co2_sim_sample_t &sample) {
+  char *end;
+  float temperature = 0;
+  float humidity = 0;
+
+  if (!isdigit((unsigned char)line[0])) return false;
+  sample.time_s = strtoul(line, &end, 10);
+  if (*end != ',') return false;
+  sample.co2_level = strtoul(end + 1, &end, 10);
+  if (*end == ',') temperature = strtod(end + 1, &end);
+  if (*end == ',') humidity = strtod(end + 1, &end);
+  sample.temp_c100 = lroundf(temperature * 100);
+  sample.humid_c100 = lroundf(humidity * 100);
+  return true;
+}
+
+bool CO2_sim::load_csv(fs::FS &fs, const char *path) {
+  char line[64];
+  uint8_t len = 0;
+  uint8_t buf[128];
+  size_t n;
+  co2_sim_sample_t sample;
+
+  if (!fs.exists(path)) return false;
+  fs::File file = fs.open(path, FILE_READ);
+  if (!file) return false;
+
+  bool room = true;
+  while (room && (n = file.read(buf, sizeof(buf))) > 0) {
+    for (size_t i = 0; i < n && room; i++) {
+      if (buf[i] != '\n') {
+        if (len < sizeof(line) - 1) line[len++] = buf[i];  // Long lines are cut short
+        continue;
+      }
+      line[len] = 0;
+      len = 0;
+      if (parse_csv_line(line, sample)) room = add_trace(sample);
+    }
+  }
+  line[len] = 0;  // Last line without a newline
+  if (room && parse_csv_line(line, sample)) add_trace(sample);
+  file.close();
+  return _trace_len > 0;
+}
+
+// The records are read oldest first, in the same way as CO2_log::restore()
+bool CO2_sim::load_log(fs::FS &fs, const char *path) {
+  co2_log_hdr_t hdr = {};
+  co2_log_rec_t recs[co2_log_batch];
+
+  if (!fs.exists(path)) return false;
+  fs::File file = fs.open(path, FILE_READ);
+  if (!file || file.read((uint8_t *)&hdr, sizeof(hdr)) != sizeof(hdr) ||
+      hdr.magic != co2_log_magic || hdr.version != co2_log_version || hdr.rec_size != sizeof(co2_log_rec_t) ||
+      hdr.capacity == 0 || hdr.head >= hdr.capacity || hdr.count > hdr.capacity)
+    return false;
+
+  bool room = true;
+  uint32_t slot = (hdr.head + hdr.capacity - hdr.count) % hdr.capacity;
+  for (uint32_t done = 0; done < hdr.count && room;) {
+    uint32_t n = std::min(std::min((uint32_t)co2_log_batch, hdr.count - done), hdr.capacity - slot);
+    if (!file.seek(co2_log_hdr_size + slot * sizeof(co2_log_rec_t)) ||
+        file.read((uint8_t *)recs, n * sizeof(co2_log_rec_t)) != n * sizeof(co2_log_rec_t))
+      break;
+
+    for (uint32_t i = 0; i < n && room; i++) {
+      const co2_log_rec_t &rec = recs[i];
+      if (rec.check != CO2_log::check_byte(rec)) continue;
+      room = add_trace({rec.time, rec.ppm, rec.temp_c100, rec.humid_c100});
+    }
+    done += n;
+    slot = (slot + n) % hdr.capacity;
+  }
+  file.close();
+  return _trace_len > 0;
+}
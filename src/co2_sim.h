@@ -0,0 +1,97 @@
+#pragma once
+//
+//    FILE: co2_sim.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: Repeatable CO2 sensor simulation, scripted room scenarios or a replayed trace
+//
+// Every sample comes from the seed, the scenario and the sample number, never from millis() or
+// Arduino random(), so two runs with the same settings see exactly the same samples however
+// fast the native build runs time.
+//
+// A scenario is one room: CO2 builds up from the outdoor level as the occupants breathe out, and
+// ventilation (air changes per hour) removes it, plus a little sensor noise. Each step ramps the
+// occupancy to a new number of people and sets the ventilation, e.g. opening the windows, and
+// can make the sensor drop out (no samples) or fail to read (I2C errors, co2_level 0 samples).
+// The steps repeat when the last one ends.
+//
+// A trace is loaded into RAM at start up and replayed at its own pace, one sample per period:
+//   CSV     One sample per line, "seconds,co2,temperature,humidity", other lines are skipped
+//   Binary  A CO2 history ring file (co2_log.h) copied from another monitor's SD card
+// A gap of more than co2_sim_hold_s between trace samples is a dropout, a co2 of 0 a failed read.
+//
+
+#include <FS.h>
+
+#include "Arduino.h"
+
+#define co2_sim_outdoor_ppm 420   // Fresh air CO2
+#define co2_sim_noise_ppm   10    // Sensor noise, +/-
+#define co2_sim_trace_max   2048  // Trace samples held in RAM, 12 bytes each
+#define co2_sim_hold_s      120   // Longest gap between trace samples that isn't a dropout
+
+enum co2_sim_event_t : uint8_t {
+  sim_event_none,
+  sim_event_dropout,    // No samples, e.g. the sensor cable is unplugged
+  sim_event_i2c_error,  // Every read fails
+};
+
+struct co2_sim_step_t {
+  uint16_t duration_s;
+  uint8_t occupants;      // People in the room at the end of the step, ramped from the last step
+  float ach;              // Air changes per hour, about 0.5 with the windows shut, 6 wide open
+  co2_sim_event_t event;
+};
+
+struct co2_sim_scenario_t {
+  const char *name;
+  float volume_m3;  // Room volume
+  const co2_sim_step_t *steps;
+  uint8_t n_steps;
+};
+
+struct co2_sim_sample_t {
+  uint32_t time_s;  // Trace time
+  uint16_t co2_level;
+  int16_t temp_c100;
+  uint16_t humid_c100;
+};
+
+extern const co2_sim_scenario_t co2_sim_scenarios[];
+extern const uint8_t co2_sim_n_scenarios;
+
+class CO2_sim {
+ public:
+  CO2_sim(void) = default;
+  ~CO2_sim(void);
+  CO2_sim(const CO2_sim &) = delete;  // Owns _trace, which a copied CO2_generic would free twice
+  CO2_sim &operator=(const CO2_sim &) = delete;
+  void begin(uint32_t seed, uint8_t scenario, uint16_t period_s);
+  bool load_csv(fs::FS &fs, const char *path);
+  bool load_log(fs::FS &fs, const char *path);
+  bool next(uint16_t &co2_level, float &temperature, float &humidity);  // False = dropout, no sample
+  const char *name(void) const { return _trace_len ? "trace" : _scenario->name; }
+  uint32_t trace_len(void) const { return _trace_len; }
+
+ private:
+  bool next_scenario(uint16_t &co2_level, float &temperature, float &humidity);
+  bool next_trace(uint16_t &co2_level, float &temperature, float &humidity);
+  bool add_trace(const co2_sim_sample_t &sample);
+  int32_t noise(int32_t range);
+
+  const co2_sim_scenario_t *_scenario = nullptr;
+  uint32_t _rng = 1;
+  uint16_t _period_s = 5;
+  uint8_t _step = 0;
+  uint32_t _step_t = 0;       // Seconds into the step
+  float _from_occupants = 0;  // Occupancy at the start of the step
+  float _co2 = co2_sim_outdoor_ppm;
+  float _temp = 20.0;
+  float _humid = 40.0;
+
+  co2_sim_sample_t *_trace = nullptr;
+  uint32_t _trace_len = 0;
+  uint32_t _trace_pos = 0;  // Next trace sample to replay
+  uint32_t _trace_t = 0;    // Replay time, in trace seconds
+};
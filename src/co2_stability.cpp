@@ -0,0 +1,80 @@
+//
+//    FILE: co2_stability.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: Decides when a CO2 reading has settled, from the mean, spread and trend of the last few samples
+//
+//
+//  HISTORY:
+//  0.0.1   2026-10-17  initial version, ends the forced recalibration wait early
+//
+
+#include "co2_stability.h"
+
+#include <math.h>
+
+CO2_stability::CO2_stability(uint16_t window) {
+  _size = window < 2 ? 2 : window;  // A slope needs two points
+  _points = new point_t[_size];
+}
+
+CO2_stability::~CO2_stability(void) {
+  delete[] _points;
+}
+
+void CO2_stability::add(uint32_t time_ms, uint16_t ppm) {
+  if (_count == 0) _t0_ms = time_ms;
+  point_t p = {(time_ms - _t0_ms) / 1000.0f, (float)ppm};
+
+  // Full, the oldest point leaves the window
+  if (_count == _size) remove(_points[_pos]);
+  _points[_pos] = p;
+  _pos = (_pos + 1) % _size;
+
+  _count++;
+  double dt = p.t - _mean_t;
+  double dppm = p.ppm - _mean_ppm;
+  _mean_t += dt / _count;
+  _mean_ppm += dppm / _count;
+  _m2_t += dt * (p.t - _mean_t);
+  _m2_ppm += dppm * (p.ppm - _mean_ppm);
+  _c_t_ppm += dt * (p.ppm - _mean_ppm);
+}
+
+// Welford's update in reverse, the means are moved back to what they were before p was added
+void CO2_stability::remove(const point_t &p) {
+  double dt = p.t - _mean_t;
+  double dppm = p.ppm - _mean_ppm;
+  _count--;
+  _mean_t -= dt / _count;
+  _mean_ppm -= dppm / _count;
+  _m2_t -= dt * (p.t - _mean_t);
+  _m2_ppm -= dppm * (p.ppm - _mean_ppm);
+  _c_t_ppm -= dt * (p.ppm - _mean_ppm);
+}
+
+void CO2_stability::clear(void) {
+  _count = 0;
+  _pos = 0;
+  _mean_t = 0;
+  _mean_ppm = 0;
+  _m2_t = 0;
+  _m2_ppm = 0;
+  _c_t_ppm = 0;
+}
+
+bool CO2_stability::settled(const co2_stability_criteria_t &criteria) const {
+  return full() && sd() <= criteria.max_sd_ppm && fabsf(slope()) <= criteria.max_slope_ppm_min;
+}
+
+// Rounding can leave the sum of squares a hair below zero once the window has slid a long way
+float CO2_stability::sd(void) const {
+  if (_count < 2 || _m2_ppm <= 0) return 0;
+  return sqrt(_m2_ppm / (_count - 1));
+}
+
+float CO2_stability::slope(void) const {
+  if (_m2_t <= 0) return 0;
+  return _c_t_ppm / _m2_t * 60;
+}
@@ -0,0 +1,56 @@
+#pragma once
+//
+//    FILE: co2_stability.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: Decides when a CO2 reading has settled, from the mean, spread and trend of the last few samples
+//
+// Mean and variance over a sliding window are kept with Welford's method, a sample is added to and
+// the oldest removed from the running values, so each sample costs the same however long the
+// window. The slope is the least squares line through the window against sample time, kept the
+// same way as the co-moment of time and CO2, so a slow drift (the sensor still warming up, or
+// the air in the bag still mixing) isn't taken for a settled reading just because it is smooth.
+//
+
+#include <stdint.h>
+
+// When a reading counts as settled. The window must be full first
+struct co2_stability_criteria_t {
+  float max_sd_ppm;         // Standard deviation over the window
+  float max_slope_ppm_min;  // Drift either way, ppm per minute
+};
+
+class CO2_stability {
+ public:
+  CO2_stability(uint16_t window);
+  ~CO2_stability(void);
+  CO2_stability(const CO2_stability &) = delete;  // Owns _points
+  CO2_stability &operator=(const CO2_stability &) = delete;
+  void add(uint32_t time_ms, uint16_t ppm);
+  void clear(void);
+  bool settled(const co2_stability_criteria_t &criteria) const;
+  uint16_t count(void) const { return _count; }
+  bool full(void) const { return _count == _size; }
+  float mean(void) const { return _mean_ppm; }
+  float sd(void) const;
+  float slope(void) const;  // ppm per minute
+
+ private:
+  struct point_t {
+    float t;  // Seconds since the first sample after clear()
+    float ppm;
+  };
+  void remove(const point_t &p);
+
+  point_t *_points;
+  uint16_t _size;
+  uint16_t _count = 0;
+  uint16_t _pos = 0;    // Oldest point once full, next slot to write
+  uint32_t _t0_ms = 0;  // millis() of the first sample after clear()
+  double _mean_t = 0;  // Double, as the window slides the rounding errors of float add up
+  double _mean_ppm = 0;
+  double _m2_t = 0;  // Sums of squared differences from the means
+  double _m2_ppm = 0;
+  double _c_t_ppm = 0;  // Co-moment of time and CO2
+};
@@ -1,19 +1,24 @@
 #include <DFRobot_VEML7700.h>
 #include <FastLED.h>
 #include <M5Unified.h>
-#include <WiFi.h>
-#include <esp_sntp.h>
+#include <SD.h>
 
 #include "DSEG7Modern40.h"
 #include "DSEG7ModernBold60.h"
-#include "RunningAverage.h"
 #include "TickTwo.h"
+#include "co2_bands.h"
+#include "co2_bargraph_lut.h"
 #include "co2_generic.h"
+#include "co2_history.h"
+#include "co2_log.h"
+#include "co2_stability.h"
+#include "ntp_sync.h"
+#include "task_timing.h"
+#include "text_format.h"
 #include "time.h"
 #include "wifi_credentials.h"
 
 // TODO Check scaling of bargraph
-// TODO Save 24-hour history to SD card
 // TODO add MENU system to set options
 
 // General defines
@@ -72,9 +77,15 @@ bool debug_mode = false;  // Set true to output some serial debug text
 #define date_txt_x time_txt_x
 #define date_txt_y (time_txt_y + 30)
 
-// NTP connection - text coordinates
-#define ntp_msg_x (M5.Lcd.width() / 2)
-#define ntp_msg_y 130
+// WiFi and NTP sync - status text in the title bar, between the battery and the time
+#define ntp_msg_x       (batt_spr_wdth + ntp_msg_w / 2)
+#define ntp_msg_y       0
+#define ntp_msg_w       108
+#define wifi_timeout_ms 7500   // Give up if the access point hasn't connected
+#define ntp_timeout_ms  30000  // Give up if the NTP server hasn't answered
+#define ntp_result_ms   3000   // How long "RTC set" or the error stays on screen
+#define ntp_tz          "ACST-9:30ACDT,M10.1.0,M4.1.0/3"  // ACST = Australian Central Standard Time (timezone)
+#define ntp_server      "0.au.pool.ntp.org"               // Also try "pool.ntp.org"
 
 // Battery icon data
 #define batt_spr_x       0    // Battery sprite X location on LCD
@@ -86,23 +97,43 @@ bool debug_mode = false;  // Set true to output some serial debug text
 #define batt_button_wdth 4
 #define batt_button_ht   6
 
-// CO2 history sizes for circular buffers
-#if defined SENSOR_IS_SCD30
-  #define co2_sec_per_sample    2   // SCD-30 CO2 sensor sample rate is 1 sample / 2 sec
-  #define co2_raw_hist_disp_pts 24  // 2 sec / sample * 24 samples = 48 seconds total
-#elif defined SENSOR_IS_SCD41
-  #define co2_sec_per_sample    5   // SCD-41 CO2 sensor sample rate is 1 sample / 5 sec
-  #define co2_raw_hist_disp_pts 24  // 5 sec / sample * 24 samples = 120 seconds total
-#elif defined SENSOR_IS_SGP30
-  #define co2_sec_per_sample    1   // SCD-41 CO2 sensor sample rate is 1 sample / 5 sec
-  #define co2_raw_hist_disp_pts 24  // 1 sec / sample * 24 samples = 24 seconds total
-#endif
-
-#define co2_raw_pts_per_min (60 / co2_sec_per_sample)   // Number of samples per minute
-#define co2_raw_hist_pts    (60 * co2_raw_pts_per_min)  // Store 1 hour of raw points
+// CO2 history sizes for circular buffers. The raw history is sized by set_raw_period() once the
+// sensor has been found at power up: SGP-30 1 s, SCD-30 2 s, SCD-41 5 s / sample
+#define co2_raw_hist_disp_pts  24    // 5 sec / sample * 24 samples = 120 seconds total on an SCD-41
+#define co2_raw_hist_s         3600  // Store 1 hour of raw points
 #define co2_minute_hist_pts 60                          // Store 1 hour of minute history
 #define co2_hour_hist_pts   24                          // Store 1 day of hour history
 
+// CO2 history saved to SD card
+#define sd_cs_pin     4                // Core2 SD card chip select
+#define sd_spi_freq   25000000         // SD card SPI clock
+#define co2_log_path  "/co2_hist.bin"  // Binary ring file, see co2_log.h
+#define co2_log_hours 48               // Hours of raw samples kept on the SD card
+
+// How an SCD-41 measures, co2_mode_t. Single shots save the most power on battery, see co2_scheduler.h
+#ifndef CO2_MODE
+  #define CO2_MODE co2_mode_periodic  // Or -D CO2_MODE=n: 0 periodic 5 s, 1 low power 30 s, 2 single shot 5 min, 3 adaptive
+#endif
+
+// CO2 simulation when no sensor is found, the same seed and scenario always give the same samples
+#ifndef SIM_SEED
+  #define SIM_SEED 1  // Or -D SIM_SEED=n in platformio.ini
+#endif
+#ifndef SIM_SCENARIO
+  #define SIM_SCENARIO 0  // co2_sim_scenarios[]: 0 office, 1 classroom, 2 faults
+#endif
+#define sim_csv_path "/co2_sim.csv"  // Trace on the SD card replayed instead of the scenario, see co2_sim.h
+#define sim_log_path "/co2_sim.bin"  // Or a CO2 history file copied from another monitor
+
+// Forced recalibration, hold BtnC for 5 seconds. Everything else keeps running meanwhile
+#define fcal_target_ppm    425   // We just assume outdoor "fresh air" is 425 ppm, it will be pretty close
+#define fcal_settle_max_s  180   // Calibrate anyway if the reading hasn't settled after 3 minutes
+#define fcal_stable_pts    12    // Samples the reading must be settled over, 1 minute of SCD-41 samples, periodic while calibrating
+#define fcal_msg_ms        1000  // "Calibration cancelled" stays on screen this long
+#define fcal_line_y        70    // First line of text, below the title bar and heading
+#define fcal_line_h        30
+#define fcal_lines         5
+
 // CO2 bargraph display
 #define co2_minute_hist_disp_pts 30  // Only display last 30 minutes otherwise bars are too narrow
 #define co2_hour_hist_disp_pts   24  // Only display last 12 hours otherwise bars are too narrow
@@ -119,6 +150,9 @@ bool debug_mode = false;  // Set true to output some serial debug text
 #define co2_hist_spr_h  140  // Bargraph Sprite height
 #define co2_spr_title_x 3    // X coordinates of co2 title
 #define co2_spr_title_y 3    // X coordinates of co2 title
+#define co2_hist_hdr_h   25                    // Height of the title, min and max text at the top of the sprite
+#define co2_hist_bar_top (co2_hist_hdr_h + 1)  // Top of the bargraph area in the sprite
+static_assert(co2_bar_ht_max == co2_hist_spr_h - 30, "Regenerate co2_bargraph_lut.h for the new sprite height");
 
 // Circular gauge pointer
 #define gauge_ptr_spr_w  20
@@ -129,35 +163,123 @@ bool debug_mode = false;  // Set true to output some serial debug text
 #define rad_2            145
 #define arc_x            (lcd_width / 2)
 #define arc_y            160
+#define gauge_max_ppm    2500  // CO2 at the right hand end of the gauge scale
+#define gauge_face_h     216   // Gauge face sprite height, down to the end of the "0" tick mark
+
+// Gauge pointer animation
+#define gauge_anim_ms         400   // Time for the pointer to move to a new value, 0 = jump straight there
+#define gauge_frame_ms        20    // Interval between animation frames, 50 frames per second
+#define gauge_frame_budget_us 4000  // A frame that takes longer than this skips the next frame
+
+// Sensor task, reads the I2C sensors on core 0 while loop() (core 1) draws the LCD
+#define sensor_task_core  0
+#define sensor_task_prio  1     // Same as loop()
+#define sensor_task_stack 4096  // Bytes
+#define sensor_task_ms    10    // Delay between polls, well inside the SCD-41 data ready poll rate
+#define sensor_queue_len  8     // Lux messages from the sensor task to loop(), must be a power of two
+
+// Sensor task to loop() messages, CO2 samples have their own queue in CO2_generic
+enum sensor_msg_type_t : uint8_t {
+  sensor_msg_lux,
+};
+
+struct sensor_msg_t {
+  sensor_msg_type_t type;
+  uint32_t time_ms;  // millis() when the sensor was read
+  float lux;
+};
+
+// Latest battery reading, owned by loop(). The AXP192 is on the Core2's internal I2C bus, with the
+// touch screen, RTC and LCD backlight, which only loop() uses
+struct batt_reading_t {
+  float volt;
+  int32_t percent;
+  bool charging;
+};
+
+// Gauge pointer animation state, owned by loop()
+struct gauge_anim_t {
+  float angle;             // Where the pointer is drawn now
+  float from_angle;        // Where it was when the animation started
+  float to_angle;          // Where it is going
+  uint32_t start_ms;       // millis() at the start of the animation
+  uint32_t last_frame_ms;  // millis() at the last frame, to count frames missed while loop() was busy
+  bool active;
+  bool skip_next;  // Last frame went over gauge_frame_budget_us
+  uint16_t frames;   // Frames drawn in the current animation
+  uint16_t skipped;  // Frames skipped in the current animation
+};
+
+// Forced recalibration steps, see update_forced_cal()
+enum {
+  fcal_confirm,  // "Really CALIBRATE CO2?"
+  fcal_reset,    // SCD-41 factory reset
+  fcal_settle,   // Waiting for the reading to settle in fresh air
+  fcal_frc,      // Recalibration running in the sensor task
+  fcal_result,   // Correction and the first post-cal sample, until BtnA
+  fcal_exit,     // Message, then back to the main screen
+};
+
+// Forced recalibration state, owned by loop()
+struct fcal_t {
+  uint8_t step;
+  uint16_t target;
+  uint32_t step_ms;  // millis() when the step started
+  uint32_t exit_ms;  // How long the fcal_exit message stays on screen
+  uint32_t shown_s;  // Countdown last drawn
+  uint16_t co2;      // Latest calibration sample
+  uint32_t co2_ms;   // millis() when it was read
+  bool new_sample;   // co2 not yet shown
+};
 
 // Function prototypes
 void start_co2_sensor(bool);
 void display_time(void);
-bool connect_wifi(uint8_t max_tries = 15);
-void sync_rtc_to_ntp(void);
+void display_ntp_status(void);
 void disp_batt_wrapper(void);
 void disp_batt_symbol(uint16_t batt_x, uint16_t batt_y, bool disp_volts);
 void display_co2_effect(const char* effect, int32_t colour);
 void display_co2_value(uint16_t co2, int32_t colour);
 void display_co2_units();
 void display_temp_humid(float temp, float humid);
-void co2_to_colour(uint16_t co2, uint32_t& led_colour, int32_t& lcd_colour, char* txt);
+void display_temp_humid_units(void);
 void read_lux_sensor(void);
 void display_lux_val();
 void set_rgb_led(uint8_t brightness, uint32_t colour);
-void save_co2_history(void);
+void save_co2_history(const co2_sample_t& sample);
+void advance_co2_history(void);
+uint32_t history_time(uint32_t time_ms);
 void main_display(void);
-uint16_t co2_to_bargraph_ht(float co2);
+void draw_co2_hist_bargraph(const CO2_ring& hist, uint16_t disp_pts, uint16_t bar_gap, int32_t bar_x0,
+                            const char* timespan, const char* wait_msg, bool redraw);
+void draw_co2_hist_bar(uint16_t co2, int32_t x, uint16_t bar_w);
 void display_title_timespan(const char* timespan);
-void display_ave_co2(float ave);
-void display_max_co2(float max);
-void display_min_co2(float min);
+void display_ave_co2(uint16_t ave);
+void display_max_co2(uint16_t max);
+void display_min_co2(uint16_t min);
 void display_wait_msg(const char* msg);
 void scd_x_forced_cal(uint16_t target_co2);
+void update_forced_cal(void);
+void start_fcal_settle(void);
+void end_forced_cal(const char* msg, int32_t colour, uint32_t show_ms);
+void draw_fcal_line(uint8_t line, const char* txt, int32_t colour);
 void scd_x_settings(float temp_offs, uint16_t alt, bool ASC);
 void sim_sensor_wrapper(void);
+void start_co2_sim(bool sd_ok);
 void draw_circular_gauge_scale(void);
-void draw_circular_gauge_pointer(uint16_t percent);
+void draw_gauge_face(LovyanGFX* dst);
+void draw_circular_gauge_pointer(uint16_t percent, bool jump);
+void animate_gauge_pointer(void);
+void draw_gauge_pointer_at(float angle);
+void gauge_pointer_rect(float angle, int32_t& x, int32_t& y, int32_t& w, int32_t& h);
+void display_task_timing(void);
+void sensor_task(void* param);
+void read_sensor_queue(void);
+void read_battery(void);
+void set_lux_brightness(void);
+void clear_screen(void);
+void push_sprite_dma(M5Canvas& sprite, int32_t x, int32_t y);
+void lcd_dma_wait(void);
 
 // Object creation
 DFRobot_VEML7700 lux;
@@ -165,19 +287,41 @@ CO2_generic co2;
 CRGB leds[LED_COUNT];                           // WS2812 RGB LED object
 TickTwo clock_display(display_time, 1000);      // Schedule time to display once per second
 TickTwo batt_display(disp_batt_wrapper, 5000);  // Schedule display battery icon every 5 seconds
-TickTwo co2_display(main_display, 500);         // Schedule CO2 display twice per second
-TickTwo co2_history(save_co2_history, 1000);    // Schedule save CO2 history every second
-TickTwo sim(sim_sensor_wrapper, 5000);          // Schedule simulation of the SCD-30 every 5 seconds
-TickTwo read_lux(read_lux_sensor, 5000);        // Schedule read of lux sensor and set LCD and RGB LED brightness
-m5::rtc_time_t RTCtime;
-m5::rtc_date_t RTCdate;
+TickTwo co2_display(main_display, 100);         // Schedule CO2 display, only what has changed is drawn
+TickTwo gauge_frame(animate_gauge_pointer, gauge_frame_ms);  // Schedule the next frame of the gauge pointer animation
+TickTwo co2_history(advance_co2_history, 1000);  // Close the minute and hour CO2 history on time
+TickTwo sim(sim_sensor_wrapper, co2_sim_period_ms);  // Schedule the simulated CO2 sensor, one sample per sample period
+TickTwo read_lux(read_lux_sensor, 5000);        // Schedule read of lux sensor (sensor task)
+TickTwo read_batt(read_battery, 5000);          // Schedule read of battery voltage and charge
+NTP_sync ntp_sync(wifi_timeout_ms, ntp_timeout_ms, ntp_result_ms);  // Sync RTC to NTP in the background
 M5Canvas batt_sprite(&M5.Lcd);                        // Sprite for battery icon and percentage text
 M5Canvas co2_hist_sprite(&M5.Lcd);                    // Sprite for CO2 history bargraph
 M5Canvas gauge_pointer(&M5.Lcd);                      // Sprite for semi circular gauge triangle pointer
 M5Canvas gauge_ticks(&M5.Lcd);                        // Sprite for semi circular gauge scale ticks
-RunningAverage co2_raw_hist(co2_raw_hist_pts);        // Circular buffer for raw CO2 samples
-RunningAverage co2_minute_hist(co2_minute_hist_pts);  // Circular buffer for minute CO2 samples
-RunningAverage co2_hour_hist(co2_hour_hist_pts);      // Circular buffer for hour CO2 samples
+M5Canvas gauge_face(&M5.Lcd);                         // Sprite for semi circular gauge scale, ticks and labels, drawn once
+uint16_t co2_sec_per_sample = co2_sim_period_ms / 1000;  // Sample period of the sensor found by start_co2_sensor()
+bool co2_period_varies = false;                          // Sensor 0 takes single shots, the time between samples varies
+CO2_history co2_hist(co2_raw_hist_s, co2_raw_hist_disp_pts, co2_sec_per_sample,  // Raw CO2 history, min/max/ave over displayed bars
+                     co2_minute_hist_pts, co2_minute_hist_disp_pts,    // Minute CO2 history
+                     co2_hour_hist_pts, co2_hour_hist_disp_pts);       // Hour CO2 history
+CO2_log co2_log(co2_log_hours * 3600 / co2_sec_per_sample);            // Raw CO2 history on SD card
+Task_timer loop_timer("loop", 0, 20000);           // loop(), over budget if it holds up the scheduled tasks for 20ms
+Task_timer display_timer("display", 100, 50000);   // main_display()
+Task_timer gauge_timer("gauge", gauge_frame_ms, gauge_frame_budget_us);  // animate_gauge_pointer(), one frame
+Task_timer history_timer("history", 0, 10000);     // save_co2_history(), once per CO2 sample
+Task_timer clock_timer("clock", 1000, 20000);      // display_time()
+Task_timer batt_timer("battery", 5000, 20000);     // disp_batt_symbol()
+Task_timer lux_timer("lux", 5000, 10000);          // read_lux_sensor()
+Task_timer sensor_timer("sensor", 0, 5000);        // One poll of the sensor task
+SPSC_queue<sensor_msg_t, sensor_queue_len> sensor_queue;  // Sensor task to loop()
+SemaphoreHandle_t sensor_mutex;                           // Held while using the CO2 or lux sensor (shared I2C bus)
+
+// Take the sensors away from the sensor task, e.g. for calibration
+class Sensor_lock {
+ public:
+  Sensor_lock(void) { xSemaphoreTake(sensor_mutex, portMAX_DELAY); }
+  ~Sensor_lock(void) { xSemaphoreGive(sensor_mutex); }
+};
 
 enum {
   display_tem_hum,
@@ -186,13 +330,27 @@ enum {
   display_hist_minute,
   display_hist_hour,
   display_lux,
+  display_timing,
   display_settings,
+  display_calibrate,  // Not in the touch screen cycle, see scd_x_forced_cal()
 };
 uint8_t display_state = display_tem_hum;
 bool display_init = false;
 uint32_t led_brightness_pc = 0;
 uint8_t lcd_brightness_pc = 0;
 float lux_float;
+uint32_t history_epoch = 0;  // RTC time at millis() == 0, seconds since 2000, see history_time()
+co2_sample_t co2_now = {};  // Latest CO2 sample, owned by loop()
+bool co2_updated = false;    // co2_now not yet displayed
+batt_reading_t batt_now = {};
+gauge_anim_t gauge_anim = {};
+bool lcd_dma_busy = false;  // A sprite is being sent to the LCD by DMA, see push_sprite_dma()
+fcal_t fcal = {};
+CO2_stability fcal_stability(fcal_stable_pts);  // Pre-cal samples, calibrate as soon as they have settled
+co2_stability_criteria_t fcal_criteria = {
+    10.0,  // Standard deviation under 10 ppm
+    5.0,   // Drifting less than 5 ppm per minute
+};
 
 /*
 -----------------
@@ -211,6 +369,7 @@ void setup(void) {
   cfg.led_brightness = 0;        // default= 0. Green LED brightness (0=off / 255=max) (※ not NeoPixel)
 
   M5.begin(cfg);
+  sensor_mutex = xSemaphoreCreateMutex();
   M5.Lcd.setBrightness(180);  // Core2 LCD backlight brightness
 
   lux.begin();
@@ -234,6 +393,13 @@ void setup(void) {
   gauge_ticks.createSprite(gauge_tick_spr_w, gauge_tick_spr_h);
   gauge_ticks.setPivot(1, rad_2 + gauge_tick_spr_h + 1);
 
+  // Semi circular gauge face, drawn once (in PSRAM) so showing the gauge only has to push it
+  gauge_face.setPsram(true);
+  if (gauge_face.createSprite(lcd_width, gauge_face_h))
+    draw_gauge_face(&gauge_face);
+  else
+    Serial.println("No memory for the gauge face sprite, the gauge will be drawn on the LCD");
+
   M5.Speaker.begin();
   // The setVolume function can be set the master volume in the range of 0-255.
   M5.Speaker.setVolume((10 * 255) / 100);
@@ -253,42 +419,54 @@ void setup(void) {
   // Start CO2 sensor and display sensor settings
   start_co2_sensor(true);
 
-#if (defined UPDATE_SETTINGS) && (defined SENSOR_IS_SCD41 || defined SENSOR_IS_SCD30)
-  scd_x_settings(temperature_offset, altitude, true);  // Uncomment to update the settings one time, which get saved to SCD-x EEPROM
+#if defined UPDATE_SETTINGS
+  if (co2.has(co2_feature_settings))
+    scd_x_settings(temperature_offset, altitude, true);  // Uncomment to update the settings one time, which get saved to SCD-x EEPROM
 #endif
 
   // If no sensor detected, switch to simulation mode
   if (co2.simulate_co2) {
-    if (debug_mode) Serial.printf("%s CO2 sensor NOT connected, switching to simulation mode\n", co2_sensor_type_str);
-    co2.co2_level = 400;
-    co2.temperature = 20.0;
-    co2.humidity = 25.0;
-    sim.start();
-    // Simulate co2 history for buffers that take ages to fill
-    for (int i = 0; i < co2_raw_hist_pts - 1; i++) {
-      co2_raw_hist.addValue((float)random(400, 5000));
-    }
-    for (int i = 0; i < co2_minute_hist_disp_pts - 1; i++) {
-      co2_minute_hist.addValue((float)random(400, 5000));
-    }
-    for (int i = 0; i < co2_hour_hist_disp_pts + 1; i++) {
-      co2_hour_hist.addValue((float)random(400, 5000));
-    }
+    if (debug_mode) Serial.println("CO2 sensor NOT connected, switching to simulation mode");
   }
 
+  // The history and the SD card log run at the sample rate of the sensor that was found, the
+  // fastest rate if it varies. Read once here, calibration changes them from the sensor task
+  co2_sec_per_sample = co2.period_ms() / 1000;
+  co2_period_varies = co2.max_period_ms() > co2.period_ms();
+  co2_hist.set_raw_period(co2_sec_per_sample, co2.max_period_ms() / 1000);
+  co2_log.set_capacity(co2_log_hours * 3600 / co2_sec_per_sample);
+
   display_init = true;
 
+  // History is timestamped from the RTC at power up, setting the RTC later doesn't move it
+  auto dt = M5.Rtc.getDateTime();
+  history_epoch = co2_log_time(dt.date.year, dt.date.month, dt.date.date, dt.time.hours, dt.time.minutes, dt.time.seconds) - millis() / 1000;
+
   // Clear the co2 circular buffers
-  co2_raw_hist.clear();
-  co2_minute_hist.clear();
-  co2_hour_hist.clear();
+  co2_hist.clear();
+
+  // Restore the co2 history saved on the SD card, simulated CO2 is not saved
+  bool sd_ok = SD.begin(sd_cs_pin, SPI, sd_spi_freq);
+  if (co2.simulate_co2)
+    start_co2_sim(sd_ok);
+  else if (sd_ok && co2_log.begin(SD, co2_log_path)) {
+    uint32_t restored = co2_log.restore(co2_hist, history_time(millis()), co2_hour_hist_pts * 3600);
+    Serial.printf("Restored %d CO2 history samples from SD card (%d saved)\n", restored, co2_log.count());
+  } else
+    Serial.println("No SD card, CO2 history will not be saved");
 
   // Start scheduled tasks
   clock_display.start();
+  gauge_frame.start();
   batt_display.start();
   co2_history.start();
   co2_display.start();
   read_lux.start();
+  read_batt.start();
+
+  // Sensor reads move to core 0, loop() keeps core 1 for the LCD, touch, LEDs and WiFi
+  if (xTaskCreatePinnedToCore(sensor_task, "sensor", sensor_task_stack, nullptr, sensor_task_prio, nullptr, sensor_task_core) != pdPASS)
+    Serial.println("Failed to start the sensor task");
 }
 
 /*
@@ -297,44 +475,39 @@ void setup(void) {
 -----------------
 */
 void loop(void) {
+  Task_probe probe(loop_timer);
   M5.update();  // check touch buttons
+  read_sensor_queue();
 
   // Indicate calibration mode will be entered while BtnB is being held
-  if (M5.BtnC.isHolding()) {
+  if (M5.BtnC.isHolding() && display_state != display_calibrate) {
     display_co2_effect("Hold to Calibrate", TFT_CYAN);
   } else
     co2_display.update();
 
   // Scheduled tasks update
   clock_display.update();
+  gauge_frame.update();
+  read_batt.update();
   batt_display.update();
   co2_history.update();
-  read_lux.update();
 
-  // Enter calibration mode after BtnB held for 5 seconds
-  if (M5.BtnC.pressedFor(5000)) {
-    scd_x_forced_cal(425);  // We just assume outdoor "fresh air" is 425 ppm, it will be pretty close
-    display_state = display_tem_hum;
-    display_init = true;
-  }
+  // Enter calibration mode after BtnB held for 5 seconds, the buttons then belong to it until it ends
+  if (display_state == display_calibrate)
+    update_forced_cal();
+  else if (M5.BtnC.pressedFor(5000))
+    scd_x_forced_cal(fcal_target_ppm);
 
-  // Connect to WiFi to sync ESP32's RTC to internet NTP sever
-  if (M5.BtnA.pressedFor(1000)) {
-    M5.Lcd.clear();
-    // Connect to WiFi
-    if (connect_wifi()) {
-      delay(500);
-      sync_rtc_to_ntp();
-      WiFi.disconnect(true);  // Disconnect wifi
-      WiFi.mode(WIFI_OFF);    // Set the wifi mode to off
-    }
-    delay(2000);
-    display_init = true;
-  }
+  // Connect to WiFi to sync ESP32's RTC to internet NTP sever, the displays keep running meanwhile
+  if (M5.BtnA.pressedFor(1000) && !ntp_sync.active() && display_state != display_calibrate)
+    ntp_sync.start(WIFI_SSID, WIFI_PASSWD, ntp_tz, ntp_server);
+  if (ntp_sync.update())
+    display_ntp_status();
 
   // Check for user change display type
   auto td = M5.Touch.getDetail();
-  if (td.wasPressed()) {
+  if (td.wasPressed() && display_state != display_calibrate) {
+    co2.measure_now();  // Someone is looking, a fresh reading if the sensor is idle between single shots
     if (td.x > lcd_width / 2 && td.y < lcd_height / 2) {
       display_init = true;
       if (display_state == display_settings)
@@ -346,12 +519,62 @@ void loop(void) {
       display_state = display_tem_hum;
     }
   }
+}
 
-  if (co2.simulate_co2)
-    sim.update();
-  else {
-    // Check if data is available from CO2 sensor
-    co2.get_co2();
+/*
+-----------------
+  Sensor task, pinned to core 0. Polls the CO2 sensor (or simulation) and lux sensor on Wire.
+  CO2 samples reach loop() through co2.read_sample(), lux readings through sensor_queue. Never
+  touches the LCD, or anything else on the internal I2C bus (M5.update(), M5.Rtc, M5.Power).
+-----------------
+*/
+void sensor_task(void* param) {
+  (void)param;
+  for (;;) {
+    {
+      Sensor_lock lock;
+      Task_probe probe(sensor_timer);
+      if (co2.simulate_co2)
+        sim.update();
+      else
+        co2.get_co2();  // Check if data is available from CO2 sensor
+      read_lux.update();
+    }
+    vTaskDelay(pdMS_TO_TICKS(sensor_task_ms));
+  }
+}
+
+/*
+-----------------
+  Take every reading the sensor task has sent since the last loop()
+-----------------
+*/
+void read_sensor_queue(void) {
+  sensor_msg_t msg;
+
+  while (co2.read_sample(co2_now)) {
+    co2_updated = true;
+    save_co2_history(co2_now);
+    if (debug_mode && co2.sensors() > 1) {
+      Serial.printf("CO2 fused=%d ppm,", co2_now.co2_level);
+      for (uint8_t i = 0; i < co2.sensors(); i++) Serial.printf(" %s=%d,", co2.name(i), co2_now.sensor_co2[i]);
+      Serial.printf(" spread=%d ppm\n", co2_now.spread);
+    }
+    // Only the sensor being calibrated, not the fused value
+    if ((co2_now.flags & co2_sample_flag_cal) && co2_now.sensor_co2[0]) {
+      fcal.co2 = co2_now.sensor_co2[0];
+      fcal.co2_ms = co2_now.time_ms;
+      fcal.new_sample = true;
+    }
+  }
+
+  while (sensor_queue.pop(msg)) {
+    switch (msg.type) {
+      case sensor_msg_lux:
+        lux_float = msg.lux;
+        set_lux_brightness();
+        break;
+    }
   }
 }
 
@@ -362,48 +585,45 @@ void loop(void) {
 -----------------
 */
 void main_display(void) {
+  Task_probe probe(display_timer);
+  lcd_dma_wait();  // The bargraph sprite may still be going to the LCD, long finished by now
   // Get LED and LCD colour based on CO2 level
-  uint32_t co2_led_colour = 0;
-  int32_t co2_lcd_colour = 0;
-  int32_t co2_lcd_colour2 = 0;
+  const co2_band_t& band = co2_to_band(co2_now.co2_level);
+  int32_t co2_lcd_colour = band.lcd_colour;
   char txt_msg[50] = "";
-  int last_sample = 0;
-  uint16_t bar_w = 0;
-  uint16_t bar_h = 0;
-  uint16_t i_shift = 0;
-  static bool display_drawn_in_colour = false;
+  static Text_cache sim_drawn;
 
-  co2_to_colour(co2.co2_level, co2_led_colour, co2_lcd_colour, txt_msg);
-  co2_lcd_colour2 = co2_lcd_colour;
-  set_rgb_led(led_brightness_pc, co2_led_colour);  // Neopixel RGB LED colour and brightness
+  set_rgb_led(led_brightness_pc, band.led_colour);  // Neopixel RGB LED colour and brightness
+  if (display_state == display_calibrate) return;    // Drawn by update_forced_cal()
 
-#if defined SENSOR_IS_SGP30
-  // Don't blink the co2 value as it updates at 1Hz
-  if (co2.co2_updated || display_init) {
-    co2.co2_updated = false;
-    display_drawn_in_colour = false;
-  } else if (display_drawn_in_colour)
-    return;
-  else
-    display_drawn_in_colour = true;
-#else
+  bool redraw = co2_updated || display_init;
+  co2_updated = false;
+  // Blink the co2 value white for half a second to indicate an update, don't on the SGP-30 as it updates at 1Hz
   static uint32_t highlight_timer = millis();
-  // Blink the co2 value white for half a second to indicate an update
-  if (co2.co2_updated || display_init) {
-    highlight_timer = millis();
-    co2.co2_updated = false;
-    display_drawn_in_colour = false;
-    co2_lcd_colour = TFT_WHITE;
-  } else if ((millis() < highlight_timer + 500) || display_drawn_in_colour)
-    return;
-  else
-    display_drawn_in_colour = true;
-#endif
+  static bool display_drawn_in_colour = false;
+  if (co2_sec_per_sample > 1) {
+    if (redraw) {
+      highlight_timer = millis();
+      display_drawn_in_colour = false;
+    }
+    if (millis() - highlight_timer < 500)
+      co2_lcd_colour = TFT_WHITE;
+    else if (!display_drawn_in_colour) {
+      display_drawn_in_colour = true;
+      redraw = true;
+    }
+  }
+
+  // The main screen only draws the fields that have changed, so it is checked on every tick, e.g. to
+  // put the CO2 effect back straight after "Hold to Calibrate". The other screens draw everything,
+  // so only when the CO2 value or its colour has changed
+  if (!redraw && display_state != display_tem_hum) return;
 
   M5.Lcd.setTextPadding(0);
 
-  // Display SIM in title bar if in Simulate mode
-  if (co2.simulate_co2) {
+  // Display SIM in title bar if in Simulate mode, unless the NTP sync status is there
+  if (ntp_sync.active()) sim_drawn.clear();  // The status is erased when the sync has finished
+  if (co2.simulate_co2 && !ntp_sync.active() && sim_drawn.changed("SIM!", TFT_ORANGE)) {
     M5.Lcd.setTextColor(TFT_ORANGE);
     M5.Lcd.setFont(&fonts::FreeSans12pt7b);
     if (display_state == dispaly_gauge) {
@@ -415,9 +635,11 @@ void main_display(void) {
   }
 
   // Prepare to display CO2 history bargraph
+  bool hist_redraw = false;
   if (display_init && (display_state == display_hist_raw || display_state == display_hist_minute || display_state == display_hist_hour)) {
     display_init = false;
-    M5.Lcd.clear();
+    hist_redraw = true;
+    clear_screen();
     co2_hist_sprite.setTextDatum(top_left);
     co2_hist_sprite.setTextColor(TFT_ORANGE, TFT_BLACK);
     co2_hist_sprite.setFont(&fonts::FreeSans9pt7b);
@@ -430,18 +652,19 @@ void main_display(void) {
     case display_tem_hum:
       if (display_init) {
         display_init = false;
-        M5.Lcd.clear();
+        clear_screen();
         display_co2_units();
+        display_temp_humid_units();
       }
-      display_co2_value(co2.co2_level, co2_lcd_colour);
-      display_temp_humid(co2.temperature, co2.humidity);
-      display_co2_effect(txt_msg, co2_lcd_colour2);
+      display_co2_value(co2_now.co2_level, co2_lcd_colour);
+      display_temp_humid(co2_now.temperature, co2_now.humidity);
+      display_co2_effect(band.msg, band.lcd_colour);
       break;
 
     case display_lux:
       if (display_init) {
         display_init = false;
-        M5.Lcd.clear();
+        clear_screen();
       }
       display_lux_val();
       break;
@@ -449,12 +672,22 @@ void main_display(void) {
     case dispaly_gauge:
       if (display_init) {
         display_init = false;
-        M5.Lcd.clear();
+        clear_screen();
         draw_circular_gauge_scale();
         display_co2_units();
+        draw_circular_gauge_pointer((co2_now.co2_level * 100) / gauge_max_ppm, true);  // No animation onto a new gauge
+      }
+      display_co2_value(co2_now.co2_level, co2_lcd_colour);
+      draw_circular_gauge_pointer((co2_now.co2_level * 100) / gauge_max_ppm, false);
+      break;
+
+    case display_timing:
+      if (display_init) {
+        display_init = false;
+        clear_screen();
+        task_timing_print();
       }
-      display_co2_value(co2.co2_level, co2_lcd_colour);
-      draw_circular_gauge_pointer((co2.co2_level * 100) / 2500);
+      display_task_timing();
       break;
 
     case display_settings:
@@ -468,102 +701,29 @@ void main_display(void) {
 
     // Raw CO2 history for last two minutes
     case display_hist_raw:
-      display_co2_value(co2.co2_level, co2_lcd_colour);
+      display_co2_value(co2_now.co2_level, co2_lcd_colour);
       display_co2_units();
-      // Erase the old bargraph, but not the outer border
-      co2_hist_sprite.fillRect(1, 1, co2_hist_spr_w - 2, co2_hist_spr_h - 2, TFT_BLACK);
-      sprintf(txt_msg, "<=%ds=>", co2_raw_hist_disp_pts * co2_sec_per_sample);
-      display_title_timespan(txt_msg);
-
-      if (co2_raw_hist.getCount() > 0) {
-        // Draw a bargraph of co2 history - for last 1 minute (12 samples)
-        last_sample = co2_raw_hist.getCount() - 1;                       // -1 as first idx == 0
-        bar_w = (co2_hist_spr_w / co2_raw_hist_disp_pts) - raw_bar_gap;  // -2 for 1 pixel gap on each side of bar
-
-        // If circular buffer has more points than being displayed, use a "shift" variable so x-axis remain on screen
-        if (last_sample >= co2_raw_hist_disp_pts)
-          i_shift = last_sample - co2_raw_hist_disp_pts + 1;
-
-        for (int i = last_sample; i >= (last_sample - co2_raw_hist_disp_pts + 1) && i >= 0; i--) {
-          bar_h = co2_to_bargraph_ht(co2_raw_hist.getValue(i));
-          co2_to_colour(co2_raw_hist.getValue(i), co2_led_colour, co2_lcd_colour, nullptr);
-          co2_hist_sprite.fillRect(7 + ((i - i_shift) * (bar_w + raw_bar_gap)), co2_hist_spr_h - bar_h + 1, bar_w, bar_h - 2, co2_lcd_colour);
-        }
-        // Display the average and max CO2 level in this history period
-        display_min_co2(co2_raw_hist.getMinInBufferLast(co2_raw_hist_disp_pts));
-        // display_ave_co2(co2_raw_hist.getAverageLast(co2_raw_hist_disp_pts));
-        display_max_co2(co2_raw_hist.getMaxInBufferLast(co2_raw_hist_disp_pts));
-      } else
-        display_wait_msg("Wait for next raw sample");
-
-      // Display the sprite
-      co2_hist_sprite.pushSprite(co2_hist_spr_x, co2_hist_spr_y);
+      if (co2_period_varies)
+        sprintf(txt_msg, "<=%d pts=>", co2_raw_hist_disp_pts);  // Single shots, the time between them varies
+      else
+        sprintf(txt_msg, "<=%ds=>", co2_raw_hist_disp_pts * co2_sec_per_sample);
+      draw_co2_hist_bargraph(co2_hist.raw, co2_raw_hist_disp_pts, raw_bar_gap, 7, txt_msg, "Wait for next raw sample", hist_redraw);
       break;
 
     // Last 30 minutes of CO2 history, each bar is an average of 1 minute of raw CO2
     case display_hist_minute:
-      display_co2_value(co2.co2_level, co2_lcd_colour);
+      display_co2_value(co2_now.co2_level, co2_lcd_colour);
       display_co2_units();
-      // Erase the old bargraph, but not the outer border
-      co2_hist_sprite.fillRect(1, 1, co2_hist_spr_w - 2, co2_hist_spr_h - 2, TFT_BLACK);
       sprintf(txt_msg, "<=%dm=>", co2_minute_hist_disp_pts);
-      display_title_timespan(txt_msg);
-
-      if (co2_minute_hist.getCount() > 0) {
-        // Draw a bargraph of co2 history - for last 30 minutes (30 samples)
-        last_sample = co2_minute_hist.getCount() - 1;                        // -1 as first idx == 0
-        bar_w = (co2_hist_spr_w / co2_minute_hist_disp_pts) - mins_bar_gap;  // -2 for 1 pixel gap on each side of bar
-
-        // If circular buffer has more points than being displayed, use a "shift" variable so x-axis remain on screen
-        if (last_sample >= co2_minute_hist_disp_pts)
-          i_shift = last_sample - co2_minute_hist_disp_pts + 1;
-
-        for (int i = last_sample; i >= (last_sample - co2_minute_hist_disp_pts + 1) && i >= 0; i--) {
-          bar_h = co2_to_bargraph_ht(co2_minute_hist.getValue(i));
-          co2_to_colour(co2_minute_hist.getValue(i), co2_led_colour, co2_lcd_colour, nullptr);
-          co2_hist_sprite.fillRect(1 + ((i - i_shift) * (bar_w + mins_bar_gap)), co2_hist_spr_h - bar_h + 1, bar_w, bar_h - 2, co2_lcd_colour);
-        }
-
-        // Display the average and max CO2 level in this history period
-        display_min_co2(co2_minute_hist.getMinInBufferLast(co2_minute_hist_disp_pts));
-        // display_ave_co2(co2_minute_hist.getAverageLast(co2_minute_hist_disp_pts));
-        display_max_co2(co2_minute_hist.getMaxInBufferLast(co2_minute_hist_disp_pts));
-      } else
-        display_wait_msg("Wait for next minute");
-      co2_hist_sprite.pushSprite(co2_hist_spr_x, co2_hist_spr_y);
+      draw_co2_hist_bargraph(co2_hist.minute, co2_minute_hist_disp_pts, mins_bar_gap, 1, txt_msg, "Wait for next minute", hist_redraw);
       break;
 
     // Last 24 hours of CO2 history, each bar is an average of 60 minutes of CO2 history
     case display_hist_hour:
-      display_co2_value(co2.co2_level, co2_lcd_colour);
+      display_co2_value(co2_now.co2_level, co2_lcd_colour);
       display_co2_units();
-      // Erase the old bargraph, but not the outer border
-      co2_hist_sprite.fillRect(1, 1, co2_hist_spr_w - 2, co2_hist_spr_h - 2, TFT_BLACK);
       sprintf(txt_msg, "<=%dhr=>", co2_hour_hist_disp_pts);
-      display_title_timespan(txt_msg);
-
-      if (co2_hour_hist.getCount() > 0) {
-        // Draw a bargraph of co2 history - for last 12 hours (12 samples)
-        last_sample = co2_hour_hist.getCount() - 1;                        // -1 as first idx == 0
-        bar_w = (co2_hist_spr_w / co2_hour_hist_disp_pts) - hour_bar_gap;  // -4 for 2 pixel gap on each side of bar
-        // If circular buffer has more points than being displayed, use a "shift" variable so x-axis remain on screen
-        if (last_sample >= co2_hour_hist_disp_pts)
-          i_shift = last_sample - co2_hour_hist_disp_pts + 1;
-
-        for (int i = last_sample; i >= (last_sample - co2_hour_hist_disp_pts + 1) && i >= 0; i--) {
-          bar_h = co2_to_bargraph_ht(co2_hour_hist.getValue(i));
-          co2_to_colour(co2_hour_hist.getValue(i), co2_led_colour, co2_lcd_colour, nullptr);
-          co2_hist_sprite.fillRect(7 + ((i - i_shift) * (bar_w + hour_bar_gap)), co2_hist_spr_h - bar_h + 1, bar_w, bar_h - 2, co2_lcd_colour);
-        }
-
-        // Display the average and max CO2 level in this history period
-        display_min_co2(co2_hour_hist.getMinInBufferLast(co2_hour_hist_disp_pts));
-        // display_ave_co2(co2_hour_hist.getAverageLast(co2_hour_hist_disp_pts));
-        display_max_co2(co2_hour_hist.getMaxInBufferLast(co2_hour_hist_disp_pts));
-
-      } else
-        display_wait_msg("Wait for next hour");
-      co2_hist_sprite.pushSprite(co2_hist_spr_x, co2_hist_spr_y);
+      draw_co2_hist_bargraph(co2_hist.hour, co2_hour_hist_disp_pts, hour_bar_gap, 7, txt_msg, "Wait for next hour", hist_redraw);
       break;
 
     default:
@@ -573,101 +733,140 @@ void main_display(void) {
 
 /*
 -----------------
-  Save co2 history to circular buffers. Raw co2 level is sampled from SCD-30 every 5 seconds.
-  Saves history in 3 circular buffers:
-    co2_raw_hist:     Raw co2 samples
-    co2_minute_hist:  1 minute CO2 samples
-    co2_hour_hist:    1 hour CO2 samples
+  Draw a CO2 history bargraph in the sprite and push it to the LCD, redrawing only what changed.
+  The bargraph only changes when its history buffer does (version() changes), so most calls return
+  straight away. When exactly one bar was added, the existing bars are scrolled left by one bar and
+  only the new bar and the header are drawn. A full redraw happens on screen change or after a clear.
+    hist      - history buffer being displayed
+    disp_pts  - number of bars on the screen
+    bar_gap   - gap in pixels between bars
+    bar_x0    - X coordinate in the sprite of the first (oldest) bar
+    redraw    - true to force a full redraw, e.g. the screen has just changed
+-----------------
+*/
+void draw_co2_hist_bargraph(const CO2_ring& hist, uint16_t disp_pts, uint16_t bar_gap, int32_t bar_x0,
+                            const char* timespan, const char* wait_msg, bool redraw) {
+  static uint32_t drawn_version = 0;
+  uint16_t count = hist.count();
+  uint16_t bar_pitch = co2_hist_spr_w / disp_pts;
+  bool one_new_bar = !redraw && count > 1 && hist.version() == drawn_version + 1;  // First bar also erases the wait message
+
+  if (!redraw && hist.version() == drawn_version) return;  // LCD is already up to date
+  drawn_version = hist.version();
+
+  // Header text always changes with a new bar (min/max), erase it but not the outer border
+  co2_hist_sprite.fillRect(1, 1, co2_hist_spr_w - 2, co2_hist_hdr_h, TFT_BLACK);
+  display_title_timespan(timespan);
+
+  if (count == 0) {
+    co2_hist_sprite.fillRect(1, co2_hist_bar_top, co2_hist_spr_w - 2, co2_hist_spr_h - co2_hist_bar_top - 1, TFT_BLACK);
+    display_wait_msg(wait_msg);
+    push_sprite_dma(co2_hist_sprite, co2_hist_spr_x, co2_hist_spr_y);
+    return;
+  }
 
-    To assist in visualisation for the user, as the minute and hour history is building in 1 element
-    the element has the cumulative average up to tha point in time.
+  // Display the min and max CO2 level in this history period
+  display_min_co2(hist.window_min());
+  // display_ave_co2(hist.window_average());
+  display_max_co2(hist.window_max());
+
+  if (one_new_bar && count > disp_pts) {
+    // Bargraph is full, scroll the bars left and draw the new bar on the right hand end
+    co2_hist_sprite.setScrollRect(bar_x0, co2_hist_bar_top, co2_hist_spr_w - 1 - bar_x0, co2_hist_spr_h - co2_hist_bar_top - 1);
+    co2_hist_sprite.scroll(-bar_pitch, 0);
+    co2_hist_sprite.clearScrollRect();
+    draw_co2_hist_bar(hist.get(count - 1), bar_x0 + (disp_pts - 1) * bar_pitch, bar_pitch - bar_gap);
+    push_sprite_dma(co2_hist_sprite, co2_hist_spr_x, co2_hist_spr_y);
+  } else if (one_new_bar) {
+    // Bargraph still filling, only the header and the new bar's column need to go to the LCD
+    int32_t bar_x = bar_x0 + (count - 1) * bar_pitch;
+    draw_co2_hist_bar(hist.get(count - 1), bar_x, bar_pitch - bar_gap);
+    M5.Lcd.setClipRect(co2_hist_spr_x, co2_hist_spr_y, co2_hist_spr_w, co2_hist_hdr_h + 1);
+    co2_hist_sprite.pushSprite(co2_hist_spr_x, co2_hist_spr_y);
+    M5.Lcd.setClipRect(co2_hist_spr_x + bar_x, co2_hist_spr_y + co2_hist_bar_top, bar_pitch - bar_gap, co2_hist_spr_h - co2_hist_bar_top);
+    co2_hist_sprite.pushSprite(co2_hist_spr_x, co2_hist_spr_y);
+    M5.Lcd.clearClipRect();
+  } else {
+    // Full redraw, if circular buffer has more points than being displayed, only draw the last disp_pts
+    co2_hist_sprite.fillRect(1, co2_hist_bar_top, co2_hist_spr_w - 2, co2_hist_spr_h - co2_hist_bar_top - 1, TFT_BLACK);
+    uint16_t first = (count > disp_pts) ? count - disp_pts : 0;
+    for (uint16_t i = first; i < count; i++)
+      draw_co2_hist_bar(hist.get(i), bar_x0 + (i - first) * bar_pitch, bar_pitch - bar_gap);
+    push_sprite_dma(co2_hist_sprite, co2_hist_spr_x, co2_hist_spr_y);
+  }
+}
 
-    Mental model of "RunningAverage" circular buffer. Once full, the previous values are on the RHS of the array, i.e.:
-      getValue(size - 1) is the last value added
-      getValue(size - 2) is the second last value added, and so on
+/*
+-----------------
+  Draw one bar of the CO2 history bargraph in the sprite, coloured by CO2 level
 -----------------
 */
-void save_co2_history(void) {
-  // static uint32_t samples = 0;
-
-  // SCD-30 samples once per 2 seconds, this will sync history to the RTC at 2 second rate
-  if (!(RTCtime.seconds % co2_sec_per_sample)) {
-    if (co2.co2_level > 0)
-      co2_raw_hist.addValue(co2.co2_level);
-    else
-      return;
-
-    // samples++;
-    // Serial.printf("sync sec=%d, co2=%d, count=%d, total samples=%d\n", RTCtime.seconds, co2.co2_level, co2_raw_hist.getCount(), samples);
-
-    // int last = co2_raw_hist.getCount() - 1;  // -1 as first idx == 0
-    // Serial.println("**** Raw history ***");
-    // for (int i = last; i > last - co2_raw_hist_pts && i >= 0; i--) {
-    //   Serial.print(co2_raw_hist.getValue(i), 0);
-    //   Serial.print("\t");
-    // }
-    // Serial.println();
-    // Serial.printf("From the last %d points: Min=%.0f, Ave=%.1f, Max=%.0f\n\n",
-    //               co2_raw_hist.getCount() < co2_raw_hist_disp_pts ? co2_raw_hist.getCount() : co2_raw_hist_disp_pts,
-    //               co2_raw_hist.getMinInBufferLast(co2_raw_hist_disp_pts),
-    //               co2_raw_hist.getAverageLast(co2_raw_hist_disp_pts),
-    //               co2_raw_hist.getMaxInBufferLast(co2_raw_hist_disp_pts));
-
-    // Save the 1-minute history
-    if (RTCtime.seconds == 0) {
-      co2_minute_hist.addValue(co2_raw_hist.getAverageLast(co2_raw_pts_per_min));
-
-      // last = co2_minute_hist.getCount() - 1;
-      // Serial.println("**************************");
-      // Serial.println("***** Minute history *****");
-      // Serial.println("**************************");
-      // for (int i = last; i > last - co2_minute_hist_pts && i >= 0; i--) {
-      //   Serial.print(co2_minute_hist.getValue(i), 1);
-      //   Serial.print("\t");
-      // }
-      // Serial.println();
-      // Serial.printf("From the last %d points: Min=%.0f, Ave=%.1f, Max=%.0f\n\n",
-      //               co2_minute_hist.getCount(),
-      //               co2_minute_hist.getMinInBuffer(),
-      //               co2_minute_hist.getAverage(),
-      //               co2_minute_hist.getMaxInBuffer());
-
-      // Save the 1-hour history
-      if (RTCtime.minutes == 0) {
-        co2_hour_hist.addValue(co2_raw_hist.getAverage());
-
-        // last = co2_hour_hist.getCount() - 1;
-        // Serial.println("****************************************************");
-        // Serial.println("******************* Hour history *******************");
-        // Serial.println("****************************************************");
-        // for (int i = last; i > last - co2_hour_hist_pts && i >= 0; i--) {
-        //   Serial.print(co2_hour_hist.getValue(i), 1);
-        //   Serial.print("\t");
-        // }
-        // Serial.println();
-        // Serial.printf("From the last %d points: Min=%.0f, Ave=%.1f, Max=%.0f\n\n",
-        //               co2_hour_hist.getCount(),
-        //               co2_hour_hist.getMinInBuffer(),
-        //               co2_hour_hist.getAverage(),
-        //               co2_hour_hist.getMaxInBuffer());
-      }
-    }
-  }
+void draw_co2_hist_bar(uint16_t co2, int32_t x, uint16_t bar_w) {
+  if (co2 == co2_gap) return;  // No samples in this period, leave the column empty
+  uint16_t bar_h = co2_to_bargraph_ht(co2);
+
+  co2_hist_sprite.fillRect(x, co2_hist_spr_h - bar_h + 1, bar_w, bar_h - 2, co2_to_band(co2).lcd_colour);
+}
+
+/*
+-----------------
+  Save a CO2 sample to the history and the SD card, called for every sample in the order they were read.
+  Saves history in 3 circular buffers of integer ppm (see co2_history.h):
+    co2_hist.raw:     Raw co2 samples
+    co2_hist.minute:  1 minute CO2 samples, average of all raw samples in that minute
+    co2_hist.hour:    1 hour CO2 samples, average of all raw samples in that hour
+
+    The sample's own timestamp decides which minute and hour it belongs to, so a late loop() or
+    setting the RTC can't drop or double count samples. Minutes or hours with no samples are
+    saved as gaps (co2_gap).
+
+    Each raw sample is also saved to the SD card (co2_log), and replayed into the buffers at boot.
+
+    The minute and hour averages come from running sums, the raw buffer is never re-scanned.
+
+    Mental model of the circular buffers. Once full, the previous values are on the RHS of the array, i.e.:
+      get(count() - 1) is the last value added
+      get(count() - 2) is the second last value added, and so on
+-----------------
+*/
+void save_co2_history(const co2_sample_t& sample) {
+  Task_probe probe(history_timer);
+  uint32_t t = history_time(sample.time_ms);
+
+  co2_hist.add(t, sample.co2_level);
+  if (sample.co2_level == co2_gap) return;  // Failed sensor read
+
+  // Batched in RAM, written to the SD card one sector at a time. The SD card shares the SPI bus with the LCD
+  lcd_dma_wait();
+  uint8_t log_flags = co2.has(co2_feature_rh_t) ? 0 : co2_log_flag_no_rh_t;
+  if (sample.flags & co2_sample_flag_cal) log_flags |= co2_log_flag_cal;
+  co2_log.add(t, sample.co2_level, sample.temperature, sample.humidity, log_flags);
 }
 
 /*
 -----------------
-  Convert co2 value into a bargraph height in pixels
-  Use google sheets to calculate the scale factor
-  https://docs.google.com/spreadsheets/d/1Qu3fMzD7Rvy_9NZa7CwBIezJ-XfksOBFPso_ldFfgO4/edit#gid=0
+  Close the minute and hour history on time, even if no samples arrive (e.g. the sensor is unplugged)
 -----------------
 */
-uint16_t co2_to_bargraph_ht(float co2) {
-  if (co2 < 400.0) co2 = 400.0;
-  uint16_t bar_height = (uint16_t)(30.0 * (log(co2) / log(2.0) - 8.64));
-  if (bar_height > co2_hist_spr_h - 30)
-    bar_height = co2_hist_spr_h - 30;
-  return bar_height;
+void advance_co2_history(void) {
+  co2_hist.advance(history_time(millis()));
+}
+
+/*
+-----------------
+  Convert a millis() timestamp to history time, seconds since 2000 on the RTC.
+  Counts on from the RTC time read at power up, so it never goes backwards when the RTC is set,
+  and carries on past millis() wrapping round every 49.7 days. Timestamps must arrive roughly
+  in order (within 24 days of each other).
+-----------------
+*/
+uint32_t history_time(uint32_t time_ms) {
+  static int64_t mono_ms = 0;   // millis() without wrapping
+  static uint32_t last_ms = 0;
+
+  mono_ms += (int32_t)(time_ms - last_ms);
+  last_ms = time_ms;
+  return history_epoch + (uint32_t)(mono_ms / 1000);
 }
 
 /*
@@ -687,19 +886,16 @@ void display_title_timespan(const char* timespan) {
   Display min co2 on history bargraph sprite
 -----------------
 */
-void display_min_co2(float min) {
-  char txt[40] = "";
-  uint32_t led_colour;
-  int32_t lcd_colour;
+void display_min_co2(uint16_t min) {
+  char txt[fmt_buf_len];
   int32_t x = co2_spr_title_x;
 
   co2_hist_sprite.setFont(&fonts::FreeSans9pt7b);
   co2_hist_sprite.setTextColor(TFT_LIGHTGRAY, TFT_BLACK);
   co2_hist_sprite.setTextDatum(top_left);
   co2_hist_sprite.drawString("Min:", x, co2_spr_title_y);
-  sprintf(txt, "%.0f", min);
-  co2_to_colour(min, led_colour, lcd_colour, nullptr);
-  co2_hist_sprite.setTextColor(lcd_colour, TFT_BLACK);
+  fmt_uint(txt, min);
+  co2_hist_sprite.setTextColor(co2_to_band(min).lcd_colour, TFT_BLACK);
   x += 40;
   co2_hist_sprite.drawString(txt, x, co2_spr_title_y);
 }
@@ -709,19 +905,16 @@ void display_min_co2(float min) {
   Display average co2 on history bargraph sprite
 -----------------
 */
-void display_ave_co2(float ave) {
-  char txt[40] = "";
-  uint32_t led_colour;
-  int32_t lcd_colour;
+void display_ave_co2(uint16_t ave) {
+  char txt[fmt_buf_len];
   int32_t x = co2_spr_title_x;
 
   co2_hist_sprite.setFont(&fonts::FreeSans9pt7b);
   co2_hist_sprite.setTextColor(TFT_LIGHTGRAY, TFT_BLACK);
   co2_hist_sprite.setTextDatum(top_left);
   co2_hist_sprite.drawString("Ave:", x, co2_spr_title_y);
-  sprintf(txt, "%.0f", ave);
-  co2_to_colour(ave, led_colour, lcd_colour, nullptr);
-  co2_hist_sprite.setTextColor(lcd_colour, TFT_BLACK);
+  fmt_uint(txt, ave);
+  co2_hist_sprite.setTextColor(co2_to_band(ave).lcd_colour, TFT_BLACK);
   x += 40;
   co2_hist_sprite.drawString(txt, x, co2_spr_title_y);
 }
@@ -731,19 +924,16 @@ void display_ave_co2(float ave) {
   Display maximum co2 on history bargraph sprite
 -----------------
 */
-void display_max_co2(float max) {
-  uint32_t led_colour;
-  int32_t lcd_colour;
-  char txt[40] = "";
+void display_max_co2(uint16_t max) {
+  char txt[fmt_buf_len];
   int32_t x = co2_spr_title_x + 205;
 
   co2_hist_sprite.setFont(&fonts::FreeSans9pt7b);
   co2_hist_sprite.setTextColor(TFT_LIGHTGRAY, TFT_BLACK);
   co2_hist_sprite.setTextDatum(top_left);
   co2_hist_sprite.drawString("Max:", x, co2_spr_title_y);
-  sprintf(txt, "%.0f", max);
-  co2_to_colour(max, led_colour, lcd_colour, nullptr);
-  co2_hist_sprite.setTextColor(lcd_colour, TFT_BLACK);
+  fmt_uint(txt, max);
+  co2_hist_sprite.setTextColor(co2_to_band(max).lcd_colour, TFT_BLACK);
   x += 40;
   co2_hist_sprite.drawString(txt, x, co2_spr_title_y);
 }
@@ -767,7 +957,9 @@ void display_wait_msg(const char* msg) {
 -----------------
 */
 void display_temp_humid(float temp, float humid) {
-  char txt[30] = "";
+  static Text_cache temp_drawn;
+  static Text_cache humid_drawn;
+  char txt[fmt_buf_len];
 
   // Prepare to display temp and humidity
   M5.Lcd.setFont(&DSEG7_Modern_Regular_40);
@@ -776,9 +968,21 @@ void display_temp_humid(float temp, float humid) {
   // Display temperature on LCD
   M5.Lcd.setTextDatum(temp_align);
   M5.Lcd.setTextColor(temp_val_colour, temp_val_bg);
-  sprintf(txt, "%2.1f", temp);
-  M5.Lcd.drawString(txt, temp_val_x, temp_val_y);
+  fmt_fixed(txt, fmt_scale(temp, 1), 1);
+  if (temp_drawn.changed(txt, temp_val_colour)) M5.Lcd.drawString(txt, temp_val_x, temp_val_y);
 
+  // Display humidity on LCD
+  M5.Lcd.setTextDatum(humid_align);
+  fmt_fixed(txt, fmt_scale(humid, 0), 0, 3);
+  if (humid_drawn.changed(txt, temp_val_colour)) M5.Lcd.drawString(txt, humid_val_x, humid_val_y);
+}
+
+/*
+-----------------
+  Display temperature and humidity units, they never change so only after the screen is cleared
+-----------------
+*/
+void display_temp_humid_units(void) {
   // Display temperature units "°C"
   M5.Lcd.setTextPadding(0);
   M5.Lcd.setTextDatum(bottom_left);
@@ -790,16 +994,7 @@ void display_temp_humid(float temp, float humid) {
   deg_sym_x += 7;
   M5.Lcd.drawString("C", deg_sym_x, temp_val_y + 3);  // "C after degree symbol"
 
-  // Display humidity on LCD
-  M5.Lcd.setFont(&DSEG7_Modern_Regular_40);
-  M5.Lcd.setTextPadding(105);
-  M5.Lcd.setTextDatum(humid_align);
-  M5.Lcd.setTextColor(temp_val_colour, temp_val_bg);
-  sprintf(txt, "%3.0f", humid);
-  M5.Lcd.drawString(txt, humid_val_x, humid_val_y);
-
   // Display humidity units "% RH"
-  M5.Lcd.setTextPadding(0);
   M5.Lcd.setTextDatum(bottom_left);
   M5.Lcd.setTextColor(temp_units_colour, temp_units_bg);
   M5.Lcd.setFont(&fonts::FreeSans12pt7b);
@@ -817,7 +1012,8 @@ void display_temp_humid(float temp, float humid) {
 -----------------
 */
 void display_co2_value(uint16_t co2, int32_t colour) {
-  char txt[30] = "";
+  static Text_cache co2_drawn;
+  char txt[fmt_buf_len];
   int32_t xx = 0;
   int32_t yy = 0;
 
@@ -837,11 +1033,13 @@ void display_co2_value(uint16_t co2, int32_t colour) {
 
   if (co2 == 0) {
     // Don't display zero values
+    if (!co2_drawn.changed("NAN", TFT_RED)) return;
     M5.Lcd.setTextColor(TFT_WHITE, TFT_RED);
     M5.Lcd.drawString("NAN", xx, yy);
   } else {
+    fmt_uint(txt, co2);
+    if (!co2_drawn.changed(txt, colour)) return;
     M5.Lcd.setTextColor(colour, TFT_BLACK);
-    sprintf(txt, "%d", co2);
     M5.Lcd.drawString(txt, xx, yy);
   }
 }
@@ -872,6 +1070,9 @@ void display_co2_units() {
 -----------------
 */
 void display_co2_effect(const char* effect, int32_t colour) {
+  static Text_cache effect_drawn;
+  if (!effect_drawn.changed(effect, colour)) return;
+
   M5.Lcd.setFont(&fonts::FreeSans18pt7b);
   M5.Lcd.setTextDatum(effect_align);
   M5.Lcd.setTextPadding(M5.Lcd.width() - 40);
@@ -879,12 +1080,58 @@ void display_co2_effect(const char* effect, int32_t colour) {
   M5.Lcd.drawString(effect, effect_txt_x, effect_txt_y);
 }
 
+/*
+-----------------
+  Clear the LCD, and forget the text drawn on it so it is all drawn again
+-----------------
+*/
+void clear_screen(void) {
+  M5.Lcd.clear();
+  Text_cache::clear_all();
+}
+
+/*
+-----------------
+  Start sending a sprite to the LCD by DMA and return straight away, so loop() carries on while it
+  is on the wire. The LCD keeps the SPI bus until lcd_dma_wait(). Drawing on the LCD meanwhile is
+  fine, it waits for the DMA by itself, but nothing may draw in the sprite or use the SD card (same
+  SPI bus) until lcd_dma_wait() has been called. The sprite must be in internal RAM, DMA can't
+  read PSRAM.
+-----------------
+*/
+void push_sprite_dma(M5Canvas& sprite, int32_t x, int32_t y) {
+  lcd_dma_wait();
+  M5.Lcd.startWrite();
+  M5.Lcd.pushImageDMA(x, y, sprite.width(), sprite.height(), (const uint16_t*)sprite.getBuffer());
+  lcd_dma_busy = true;
+}
+
+/*
+-----------------
+  Wait for push_sprite_dma() to finish, and give the SPI bus back
+-----------------
+*/
+void lcd_dma_wait(void) {
+  if (!lcd_dma_busy) return;
+  M5.Lcd.endWrite();  // Waits for the DMA to finish
+  lcd_dma_busy = false;
+}
+
 /*
 -----------------
   Set the Neopixel RGB LED brightness in % and colour
 -----------------
 */
 void set_rgb_led(uint8_t brightness_pc, uint32_t colour) {
+  // The LEDs keep their colour, only send it again when it changes
+  static uint8_t last_brightness_pc = 0;
+  static uint32_t last_colour = 0;
+  static bool leds_set = false;
+  if (leds_set && brightness_pc == last_brightness_pc && colour == last_colour) return;
+  leds_set = true;
+  last_brightness_pc = brightness_pc;
+  last_colour = colour;
+
   FastLED.setBrightness((brightness_pc * 255) / 100);
   // M5 Core2 base has x10 LEDs around the base
 
@@ -907,7 +1154,7 @@ void set_rgb_led(uint8_t brightness_pc, uint32_t colour) {
 #define lux_lev_3  100.0
 
 void display_lux_val() {
-  char lux_str[40] = "";
+  char lux_str[fmt_buf_len * 3];
   int32_t x = 10;
   int32_t y = 50;
 
@@ -933,7 +1180,11 @@ void display_lux_val() {
   M5.Lcd.setTextColor(TFT_WHITE, TFT_DARKGRAY);
   M5.Lcd.drawString("Lux levels", x, y);
   y += 27;
-  sprintf(lux_str, "%.0f--%.0f--%.0f", lux_lev_1, lux_lev_2, lux_lev_3);
+  fmt_uint(lux_str, lux_lev_1);
+  strcat(lux_str, "--");
+  fmt_uint(lux_str + strlen(lux_str), lux_lev_2);
+  strcat(lux_str, "--");
+  fmt_uint(lux_str + strlen(lux_str), lux_lev_3);
   M5.Lcd.setTextColor(TFT_LIGHTGRAY, TFT_BLACK);
   M5.Lcd.drawString(lux_str, x, y);
 
@@ -942,28 +1193,40 @@ void display_lux_val() {
   M5.Lcd.setTextDatum(top_right);
   M5.Lcd.setTextColor(colour_toggle ? color_true : color_false, TFT_BLACK);
 
-  sprintf(lux_str, "%.1f", lux_float);
+  fmt_fixed(lux_str, fmt_scale(lux_float, 1), 1);
   M5.Lcd.drawString(lux_str, x, y);
 
   y += 27;
-  sprintf(lux_str, "%3d%%", led_brightness_pc);
+  strcat(fmt_uint(lux_str, led_brightness_pc, 3), "%");
   M5.Lcd.drawString(lux_str, x, y);
 
   y += 27;
-  sprintf(lux_str, "%3d%%", lcd_brightness_pc);
+  strcat(fmt_uint(lux_str, lcd_brightness_pc, 3), "%");
   M5.Lcd.drawString(lux_str, x, y);
 }
 
 /*
 -----------------
-  Read VEML7700 lux sensor and set LED and LCD brightness
+  Read VEML7700 lux sensor and send it to loop(), sensor task only
 -----------------
 */
 void read_lux_sensor(void) {
-  lux.getALSLux(lux_float);
+  Task_probe probe(lux_timer);
+  sensor_msg_t msg = {};
+  msg.type = sensor_msg_lux;
+  msg.time_ms = millis();
+  lux.getALSLux(msg.lux);
   // Auto ranging lux, can take up to 5 or 6 seconds in very low light
-  // lux.getAutoALSLux(lux_float);
+  // lux.getAutoALSLux(msg.lux);
+  sensor_queue.push(msg);
+}
 
+/*
+-----------------
+  Set LED and LCD brightness from the last lux reading
+-----------------
+*/
+void set_lux_brightness(void) {
   if (lux_float < lux_lev_1) {
     led_brightness_pc = 5;
     lcd_brightness_pc = 30;
@@ -990,54 +1253,13 @@ void read_lux_sensor(void) {
 
 /*
 -----------------
-  Obtain LED and LCD text colour from CO2 level
+  Read battery voltage, charge and charging state, loop() only
 -----------------
 */
-void co2_to_colour(uint16_t co2, uint32_t& led_colour, int32_t& lcd_colour, char* txt) {
-  // Set the RGB LEDs based on CO2 level from https://www.kane.co.uk/knowledge-centre/what-are-safe-levels-of-co-and-co2-in-rooms
-  // Assume indoor CO2 levels
-  switch (co2) {
-    case 1 ... 1000:
-      // Should never be below 400, but wind currents on the sensor can make this happen
-      // So just detect anything above zero, zero is normally a bad connection with the sensor
-      // CO2 400 - 1000: OK good air exchange
-      if (txt != nullptr) strcpy(txt, "Good air quality");
-      led_colour = CRGB::Green;
-      lcd_colour = TFT_GREEN;
-      break;
-
-    case 1001 ... 2000:
-      // CO2 1000 - 2000: Drowsy and poor air
-      if (txt != nullptr) strcpy(txt, "Drowsy, poor air");
-      led_colour = CRGB::Yellow;
-      lcd_colour = TFT_YELLOW;
-      break;
-
-    // 5,000 is max value reported by Sensirion SCD-30 (I've actually seen 6,250 but that's not as per the datasheet)
-    case 2001 ... 5000:
-      //    Headaches, sleepiness and stagnant, stale, stuffy air.
-      //    Poor concentration, loss of attention, increased heart rate and slight nausea may be present.
-      if (txt != nullptr) strcpy(txt, "Headache, sleepy");
-      led_colour = CRGB::Red;
-      lcd_colour = TFT_RED;
-      break;
-
-    // 10,000 is max value reported by Sensirion SCD-30
-    case 5001 ... 65535:
-      //    Workplace 8-hr exposure limit
-      if (txt != nullptr) strcpy(txt, "8-hr exposure limit");
-      led_colour = CRGB::Red;
-      lcd_colour = TFT_RED;
-      break;
-
-    case 0:
-    default:
-      // PINK indicates an error
-      if (txt != nullptr) strcpy(txt, "Bad CO2 read :(");
-      led_colour = CRGB::Pink;
-      lcd_colour = TFT_MAGENTA;
-      break;
-  }
+void read_battery(void) {
+  batt_now.volt = M5.Power.Axp192.getBatteryVoltage();
+  batt_now.percent = M5.Power.getBatteryLevel();
+  batt_now.charging = M5.Power.isCharging();
 }
 
 /*
@@ -1046,6 +1268,7 @@ void co2_to_colour(uint16_t co2, uint32_t& led_colour, int32_t& lcd_colour, char
 -----------------
 */
 void disp_batt_wrapper(void) {
+  Task_probe probe(batt_timer);
   disp_batt_symbol(batt_spr_x, batt_spr_y, false);
 }
 
@@ -1067,22 +1290,12 @@ void disp_batt_symbol(uint16_t batt_x, uint16_t batt_y, bool disp_volts) {
   uint16_t txt_colour = TFT_LIGHTGRAY;
   const uint16_t erase_fill_colour = TFT_BACKGND;
 
-  // Read battery voltage
-  batt_volt = M5.Power.Axp192.getBatteryVoltage();
-  batt_percent = M5.Power.getBatteryLevel();
+  // Last battery voltage read by read_battery()
+  batt_volt = batt_now.volt;
+  batt_percent = batt_now.percent;
   batt_fill_length = (batt_percent * batt_rect_width) / 100;
   if (debug_mode) Serial.printf("BatVoltage= %.1f, BattLevel=%d\n", batt_volt, batt_percent);
 
-  // Clear the old values
-  batt_sprite.fillSprite(erase_fill_colour);  // Clear the battery icon sprite
-
-  // Display battery percentage
-  char txt[20] = "";
-  batt_sprite.setTextColor(txt_colour, TFT_BLACK);
-  batt_sprite.setFont(&FreeSans12pt7b);
-  batt_sprite.setTextDatum(middle_right);
-  batt_sprite.setTextPadding(64);
-
   uint16_t spr_x = 67;               // X-axis offset of battery icon and voltage text in sprite
   uint16_t spr_y = batt_spr_ht / 2;  // Y-axis offset of battery icon and voltage text in sprite
 
@@ -1093,13 +1306,31 @@ void disp_batt_symbol(uint16_t batt_x, uint16_t batt_y, bool disp_volts) {
     return;
   }
 
-  sprintf(txt, "%3d%%", batt_percent);
-  batt_sprite.drawString(txt, spr_x, spr_y);
+  // Nothing to draw if the percentage, voltage and charging symbol haven't changed since last time
+  static Text_cache percent_drawn;
+  static Text_cache volt_drawn;
+  char percent_txt[fmt_buf_len];
+  char volt_txt[fmt_buf_len] = "";
+  strcat(fmt_fixed(percent_txt, batt_percent, 0, 3), "%");
+  if (disp_volts) strcat(fmt_fixed(volt_txt, fmt_scale(batt_volt, 2), 2), "V");
+  bool changed = percent_drawn.changed(percent_txt, batt_now.charging);
+  if (volt_drawn.changed(volt_txt, 0)) changed = true;
+  if (!changed) return;
+
+  // Clear the old values
+  lcd_dma_wait();  // Not while the sprite is still going to the LCD
+  batt_sprite.fillSprite(erase_fill_colour);  // Clear the battery icon sprite
+
+  // Display battery percentage
+  batt_sprite.setTextColor(txt_colour, TFT_BLACK);
+  batt_sprite.setFont(&FreeSans12pt7b);
+  batt_sprite.setTextDatum(middle_right);
+  batt_sprite.setTextPadding(64);
+  batt_sprite.drawString(percent_txt, spr_x, spr_y);
 
   if (disp_volts) {
     spr_x += 73;
-    sprintf(txt, "%.2fV", batt_volt);
-    batt_sprite.drawString(txt, spr_x, spr_y);
+    batt_sprite.drawString(volt_txt, spr_x, spr_y);
   }
 
   if (batt_percent < 20)
@@ -1124,7 +1355,7 @@ void disp_batt_symbol(uint16_t batt_x, uint16_t batt_y, bool disp_volts) {
   batt_sprite.fillRect(spr_x + 1, spr_y + 1, batt_fill_length - 2, batt_rect_height - 2, fill_colour);
 
   // Draw lighning bolt symbol
-  if (M5.Power.isCharging()) {
+  if (batt_now.charging) {
     uint16_t cntre_x = spr_x + (batt_rect_width / 2);
     uint16_t cntre_y = spr_y + (batt_rect_height / 2) - 1;
     batt_sprite.fillTriangle(cntre_x - 15, cntre_y - 2, cntre_x, cntre_y, cntre_x + 2, cntre_y + 6, TFT_ORANGE);
@@ -1132,107 +1363,32 @@ void disp_batt_symbol(uint16_t batt_x, uint16_t batt_y, bool disp_volts) {
   }
 
   // Display the sprite
-  batt_sprite.pushSprite(batt_x, batt_y);
+  push_sprite_dma(batt_sprite, batt_x, batt_y);
 }
 
 /*
 -----------------
-  Connect ESP32 to WiFi
-  max_tries - how many 500ms delays to wait for WiFi to connect. Default is 15 (in function declaration)
-  connected - true if WiFi is connected
+  Display WiFi and NTP sync progress in the title bar, or erase it once the sync has finished
 -----------------
 */
-bool connect_wifi(uint8_t max_tries) {
-  bool connected = false;
-  char msg[20] = "";
-  uint8_t tries_count = 0;
-
-  // Start WiFi
-  WiFi.begin(WIFI_SSID, WIFI_PASSWD);
-
-  // Display WiFi starting message
-  M5.Lcd.setTextDatum(top_center);
-  M5.Lcd.setFont(&fonts::FreeSans18pt7b);
-  M5.Lcd.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
-  M5.Lcd.drawString("Starting WiFi", M5.Lcd.width() / 2, 80);
+void display_ntp_status(void) {
+  uint16_t colour = TFT_CYAN;
 
-  // Set location where "connecting..." dots will appear
-  M5.Lcd.setCursor(110, 120);
-
-  do {
-    delay(500);
-    M5.Lcd.print(".");
-    tries_count++;
-    connected = (WiFi.status() == WL_CONNECTED);
-  } while (!connected && (tries_count < max_tries));
-
-  // M5.Lcd.setFont(&fonts::FreeSans12pt7b);
-  if (connected)
-    strcpy(msg, "Connected!");
-  else
-    // WiFi not connected
-    strcpy(msg, "Not connected");
-  M5.Lcd.setTextPadding(280);
-  M5.Lcd.drawString(msg, M5.Lcd.width() / 2, 80);
+  if (!ntp_sync.active()) {
+    M5.Lcd.fillRect(ntp_msg_x - ntp_msg_w / 2, ntp_msg_y, ntp_msg_w, batt_spr_ht, TFT_BLACK);
+    return;
+  }
 
-  return connected;
-}
-
-/*
------------------
-  Configures the timezone, queries NTP for data and time, and sets RTC chip with the result
------------------
-*/
-void sync_rtc_to_ntp(void) {
-  char time_txt[80] = "";
-  struct tm* timeinfo;
+  if (ntp_sync.state() == ntp_synced)
+    colour = TFT_GREEN;
+  else if (ntp_sync.state() == ntp_failed)
+    colour = TFT_RED;
 
   M5.Lcd.setTextDatum(top_center);
-  M5.Lcd.setFont(&fonts::FreeSans12pt7b);
-  M5.Lcd.setTextColor(TFT_CYAN, TFT_BLACK);
-  M5.Lcd.setTextPadding(M5.Lcd.textWidth("Syncing to NTP time"));
-  M5.Lcd.drawString("Syncing to NTP time", ntp_msg_x, ntp_msg_y);
-
-  // See example: https://github.com/m5stack/M5Unified/blob/master/examples/Basic/Rtc/Rtc.ino
-  // See pull request: https://github.com/m5stack/M5Unified/pull/20
-  //
-  // Also try "0.au.pool.ntp.org"
-  // configTzTime("ACST-9:30ACDT,M10.1.0,M4.1.0/3", "pool.ntp.org");  // ACST = Australian Central Standard Time (timezone)
-  configTzTime("ACST-9:30ACDT,M10.1.0,M4.1.0/3", "0.au.pool.ntp.org");  // ACST = Australian Central Standard Time (timezone)
-
-  // Epoch time variable, i.e. number of seconds since 1-1-1970 UTC
-  time_t t;
-
-  // Wait until NTP sync has finished. Sets ESP32 internal RTC
-  Serial.println("Syncing with NTP time");
-  // Set location where "connecting..." dots will appear
-  M5.Lcd.setCursor(110, 160);
-  M5.Lcd.setFont(&fonts::FreeSans18pt7b);  // Set larger font to display probress dots "....""
-
-  while (sntp_get_sync_status() == SNTP_SYNC_STATUS_RESET) {
-    Serial.print('.');
-    M5.Lcd.print(".");
-    delay(1000);
-  }
-  Serial.println("\r\n NTP Connected.");
-  t = time(nullptr) + 1;  // Advance one second
-  while (t > time(nullptr))
-    ;                            /// Synchronization in seconds
-  timeinfo = localtime(&t);      // Convert epoch time to a "tm" structure
-  M5.Rtc.setDateTime(timeinfo);  // Writes the date and time to the Core2's external RTC chip
-
-#if (CORE_DEBUG_LEVEL == 4)
-  strftime(time_txt, 80, "%A %e-%m-%Y, %H:%M:%S", timeinfo);
-  log_d("NTP time is: %s", time_txt);
-
-  log_d("timeinfo: tm_mday=%d tm_mon=%d tm_wday=%d tm_year=%d",
-        (uint8_t)timeinfo->tm_hour, (uint8_t)(timeinfo->tm_mon + 1), (uint8_t)timeinfo->tm_wday, (uint16_t)(timeinfo->tm_year + 1900));
-  log_d("timeinfo: tm_hour=%d tm_min=%d tm_sec=%d\n", timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec);
-#endif
-
-  M5.Lcd.setFont(&fonts::FreeSans12pt7b);
-  M5.Lcd.setTextColor(TFT_GREEN, TFT_BLACK);
-  M5.Lcd.drawString("RTC synced to NTP", ntp_msg_x, ntp_msg_y);
+  M5.Lcd.setFont(&fonts::FreeSans9pt7b);
+  M5.Lcd.setTextColor(colour, TFT_BLACK);
+  M5.Lcd.setTextPadding(ntp_msg_w);
+  M5.Lcd.drawString(ntp_sync.status(), ntp_msg_x, ntp_msg_y);
 }
 
 /*
@@ -1241,168 +1397,215 @@ void sync_rtc_to_ntp(void) {
 -----------------
 */
 void display_time(void) {
-#define str_size 50
-  char time_str[str_size];
+  Task_probe probe(clock_timer);
+  static Text_cache time_drawn;
+  char time_str[fmt_buf_len];
 
   // Read time from real-time clock
   auto dt = M5.Rtc.getDateTime();
-  RTCtime.seconds = dt.time.seconds;  // Pass the time to the global var RTCtime
-  RTCtime.minutes = dt.time.minutes;  // Pass the time to the global var RTCtime
 
   // Display date
-  sprintf(time_str, "%02d-%02d-%04d", dt.date.date, dt.date.month, dt.date.year);
+  // sprintf(time_str, "%02d-%02d-%04d", dt.date.date, dt.date.month, dt.date.year);
   M5.Lcd.setTextDatum(time_align);
   M5.Lcd.setTextColor(TFT_LIGHTGRAY, TFT_BLACK);
   M5.Lcd.setFont(&fonts::FreeSans12pt7b);
   M5.Lcd.setTextPadding(96);
   // M5.Lcd.drawString(time_str, date_txt_x, date_txt_y);
 
-  // Display time
-  sprintf(time_str, "%02d:%02d:%02d", dt.time.hours, dt.time.minutes, dt.time.seconds);
-  M5.Lcd.drawString(time_str, time_txt_x, time_txt_y);
+  // Display time, skipped if the clock hasn't moved on since it was last drawn
+  fmt_hms(time_str, dt.time.hours, dt.time.minutes, dt.time.seconds);
+  if (time_drawn.changed(time_str, TFT_LIGHTGRAY)) M5.Lcd.drawString(time_str, time_txt_x, time_txt_y);
+
+  // Put the sync status back if the screen has been cleared
+  if (ntp_sync.active()) display_ntp_status();
 }
 
 /*
 -----------------
-  Perform a FRC calibration on either a SCD-30 or SCD-41 CO2 sensor
-  Needs sensor to be placed into a known CO2 concentration for 3 mins before calibration
+  Start a FRC calibration on either a SCD-30 or SCD-41 CO2 sensor. Needs sensor to be placed into
+  a known CO2 concentration until the reading settles. The calibration then runs one step at a
+  time from loop() (update_forced_cal()) and the sensor task, so the history, clock and LEDs carry on
 -----------------
 */
 void scd_x_forced_cal(uint16_t target_co2) {
-  uint32_t start_time = millis();
-  uint32_t duration = 0;
-  uint32_t last_disp_time = 0;
-  int32_t x = 0;
-  int32_t y = 5;
   char txt[40] = "";
 
-  M5.Lcd.clear();
-  M5.Lcd.setFont(&fonts::FreeSans12pt7b);
-  M5.Lcd.setTextDatum(top_left);
-  M5.Lcd.setTextColor(TFT_WHITE, TFT_BLACK);
-  M5.Lcd.setTextPadding(M5.Lcd.width());
-
-#if defined SENSOR_IS_SCD41 || defined SENSOR_IS_SCD30
-  M5.Lcd.drawString("Really CALIBRATE CO2?", x, y);
-  M5.Lcd.drawString("BtnB to CANCEL!", x, y + 30);
-  M5.Lcd.drawString("BtnA to Continue", x, y + 60);
-#elif defined SENSOR_IS_SGP30
-  M5.Lcd.drawString("Can't calibrate", x, y);
-  sprintf(txt, "%s CO2 sensor", co2_sensor_type_str);
-  M5.Lcd.drawString(txt, x, y + 30);
-  delay(3000);
-  M5.Lcd.clear();
-  return;
-#endif
-
-  bool btnA = false;
-  bool btnB = false;
-  do {
-    M5.update();
-    delay(1);
-    btnA = M5.BtnA.wasClicked();
-    btnB = M5.BtnB.wasClicked();
-  } while (!btnA && !btnB);
+  fcal = {};
+  fcal.target = target_co2;
+  fcal.step_ms = millis();
+  display_state = display_calibrate;
+  clear_screen();
+  M5.Lcd.setFont(&fonts::FreeSans18pt7b);
+  M5.Lcd.setTextDatum(top_center);
+  M5.Lcd.setTextColor(TFT_YELLOW, TFT_BLACK);
+  M5.Lcd.setTextPadding(0);
+  M5.Lcd.drawString("Calibrate sensor", lcd_width / 2, fcal_line_y - fcal_line_h - 10);
 
-  if (btnB) {
-    M5.Lcd.setTextColor(TFT_WHITE, TFT_RED);
-    M5.Lcd.drawString("Calibration cancelled", x, y + 90);
-    delay(1000);
-    M5.Lcd.clear();
+  if (!co2.simulate_co2 && co2.has(co2_feature_frc)) {
+    draw_fcal_line(0, "Really CALIBRATE CO2?", TFT_WHITE);
+    draw_fcal_line(1, "BtnB to CANCEL!", TFT_WHITE);
+    draw_fcal_line(2, "BtnA to Continue", TFT_WHITE);
+    fcal.step = fcal_confirm;
     return;
   }
 
-  x = M5.Lcd.width() / 2;
-  M5.Lcd.clear();
-  M5.Lcd.setFont(&fonts::FreeSans18pt7b);
-  M5.Lcd.setTextDatum(top_center);
-  M5.Lcd.setTextColor(TFT_YELLOW, TFT_BLACK);
-  M5.Lcd.drawString("Calibrate sensor", x, y);
+  draw_fcal_line(0, "Can't calibrate", TFT_WHITE);
+  sprintf(txt, "%s CO2 sensor", co2.simulate_co2 ? "simulated" : co2.name());
+  draw_fcal_line(1, txt, TFT_WHITE);
+  end_forced_cal(nullptr, TFT_WHITE, 3000);
+}
 
-  M5.Lcd.setFont(&fonts::FreeSans12pt7b);
-  M5.Lcd.setTextDatum(top_left);
-  M5.Lcd.setTextColor(TFT_WHITE, TFT_BLACK);
-  M5.Lcd.setTextPadding(M5.Lcd.width());
-  x = 0;
-  y = 40;
-
-#if defined SENSOR_IS_SCD41
-  M5.Lcd.drawString("Wait 10s for factory reset", x, y);
-  Serial.println("Wait 10s for factory reset");
-  co2.factory_reset();
-#endif
+/*
+-----------------
+  One step of the forced calibration, called from every loop() while it is on screen
+-----------------
+*/
+void update_forced_cal(void) {
+  char txt[40] = "";
+  co2_cal_state_t state = co2.cal_state();
+  uint32_t step_s = (millis() - fcal.step_ms) / 1000;
+
+  switch (fcal.step) {
+    case fcal_confirm:
+      if (M5.BtnB.wasClicked()) {
+        end_forced_cal("Calibration cancelled", TFT_RED, fcal_msg_ms);
+      } else if (M5.BtnA.wasClicked()) {
+        {
+          Sensor_lock lock;
+          co2.cal_begin(true);  // Factory reset the SCD-41 first, to clear out the previous calibration
+        }
+        for (uint8_t line = 0; line < fcal_lines; line++) draw_fcal_line(line, "", TFT_WHITE);
+        if (co2.has(co2_feature_reset)) {
+          Serial.println("Wait 10s for factory reset");
+          draw_fcal_line(0, "Wait 10s for factory reset", TFT_WHITE);
+          fcal.step = fcal_reset;
+          fcal.step_ms = millis();
+        } else
+          start_fcal_settle();
+      }
+      break;
 
-  Serial.printf("Put in CO2=%d ppm for 3 minutes, or press BtnA when ready.\n", target_co2);
-  sprintf(txt, "Put in CO2=%d ppm 3 mins", target_co2);
-  M5.Lcd.drawString(txt, x, y);
-  y += 30;
-  // M5.Lcd.setTextPadding(280);
-  M5.Lcd.setTextColor(TFT_CYAN, TFT_BLACK);
-  M5.Lcd.drawString("BtnB to cancel calibration", x, y + 60);
-  M5.Lcd.setTextColor(TFT_WHITE, TFT_BLACK);
+    case fcal_reset:
+      if (state == cal_measuring)
+        start_fcal_settle();
+      else if (state == cal_failed)
+        end_forced_cal("Error during factory reset", TFT_RED, 3000);
+      break;
 
-  do {
-    if (co2.get_co2()) {
-      Serial.printf("Pre-cal CO2=%d ppm\n", co2.co2_level);
-      sprintf(txt, "Pre-cal CO2=%d ppm", co2.co2_level);
-      M5.Lcd.drawString(txt, x, y);
-    }
+    case fcal_settle: {
+      bool stable = false;
+      if (fcal.new_sample) {
+        fcal.new_sample = false;
+        Serial.printf("Pre-cal CO2=%d ppm\n", fcal.co2);
+        sprintf(txt, "Pre-cal CO2=%d ppm", fcal.co2);
+        draw_fcal_line(1, txt, TFT_WHITE);
+
+        fcal_stability.add(fcal.co2_ms, fcal.co2);
+        if (fcal_stability.full()) {
+          stable = fcal_stability.settled(fcal_criteria);
+          sprintf(txt, "SD %.1f, %+.1f ppm/min", fcal_stability.sd(), fcal_stability.slope());
+          draw_fcal_line(3, txt, stable ? TFT_GREEN : TFT_WHITE);
+        }
+      }
 
-    duration = (millis() - start_time) / 1000;
-    if (duration > last_disp_time) {
-      last_disp_time = duration;
-      Serial.printf("Wait for = %d sec\n", (3 * 60) - duration);
-      sprintf(txt, "Wait for %3d sec", (3 * 60) - duration);
-      M5.Lcd.drawString(txt, x, y + 30);
-    }
-    M5.update();
-    if (M5.BtnB.wasClicked()) {
-      M5.Lcd.setTextColor(TFT_RED, TFT_BLACK);
-      M5.Lcd.drawString("Calibration cancelled", x, y + 90);
-      delay(1000);
-      M5.Lcd.clear();
-      return;
+      if (step_s != fcal.shown_s) {
+        fcal.shown_s = step_s;
+        sprintf(txt, "Wait for %3d sec", fcal_settle_max_s - step_s);
+        draw_fcal_line(2, txt, TFT_WHITE);
+      }
+
+      if (M5.BtnB.wasClicked()) {
+        end_forced_cal("Calibration cancelled", TFT_RED, fcal_msg_ms);
+      } else if (stable || step_s >= fcal_settle_max_s || M5.BtnA.wasClicked()) {
+        Serial.printf("Calibrating to %d ppm after %d sec, %s: mean %.1f ppm, SD %.1f ppm, slope %+.1f ppm/min\n",
+                      fcal.target, step_s, stable ? "settled" : "not settled", fcal_stability.mean(), fcal_stability.sd(), fcal_stability.slope());
+        {
+          Sensor_lock lock;
+          co2.calibrate(fcal.target);
+        }
+        draw_fcal_line(2, "", TFT_WHITE);
+        draw_fcal_line(3, "Calibrating NOW!", TFT_GREEN);
+        draw_fcal_line(4, "", TFT_WHITE);
+        fcal.step = fcal_frc;
+      }
+      break;
     }
-  } while (!M5.BtnA.wasClicked() && duration < (3 * 60));
-
-  Serial.printf("Calibrating to %d ppm\n", target_co2);
-  y += 60;
-  M5.Lcd.setTextColor(TFT_GREEN, TFT_BLACK);
-  M5.Lcd.drawString("Calibrating NOW!", x, y);
-  y += 30;
-
-  int16_t correction = 0;
-  correction = co2.calibrate(target_co2);
-  delay(400);  // Required by Sensirion SCD-41 datasheet
-  if (correction == 0) {
-    Serial.println("Error trying to execute calibration");
-    M5.Lcd.setTextColor(TFT_WHITE, TFT_RED);
-    M5.Lcd.drawString("Error during calibration", x, y);
-  } else {
-    Serial.printf("FRC calibration factor = %d\n", correction);
-    sprintf(txt, "Cal correction %d ppm", correction);
-    M5.Lcd.setTextColor(TFT_WHITE, TFT_BLACK);
-    M5.Lcd.drawString(txt, x, y);
+
+    case fcal_frc:
+      if (state == cal_done) {
+        Serial.printf("FRC calibration factor = %d\n", co2.cal_correction());
+        sprintf(txt, "Cal correction %d ppm", co2.cal_correction());
+        draw_fcal_line(3, txt, TFT_WHITE);
+      } else if (state == cal_failed) {
+        Serial.println("Error trying to execute calibration");
+        draw_fcal_line(3, "Error during calibration", TFT_RED);
+      } else
+        break;
+      draw_fcal_line(2, "Post-cal CO2 = wait", TFT_WHITE);
+      draw_fcal_line(4, "Press BtnA to exit", TFT_WHITE);
+      fcal.new_sample = false;
+      fcal.step = fcal_result;
+      break;
+
+    case fcal_result:
+      if (fcal.new_sample) {
+        fcal.new_sample = false;
+        Serial.printf("Post-cal CO2 = %d\n", fcal.co2);
+        sprintf(txt, "Post-cal CO2 = %d ppm", fcal.co2);
+        draw_fcal_line(2, txt, TFT_WHITE);
+      }
+      if (M5.BtnA.wasClicked()) end_forced_cal(nullptr, TFT_WHITE, 0);
+      break;
+
+    case fcal_exit:
+      if (millis() - fcal.step_ms >= fcal.exit_ms) {
+        display_state = display_tem_hum;
+        display_init = true;
+        clear_screen();
+      }
+      break;
   }
+}
 
-  start_time = millis();
-  do {
-    delay(200);
-  } while (!co2.get_co2() && (millis() < start_time + 5000));
+void start_fcal_settle(void) {
+  char txt[40] = "";
 
-  M5.Lcd.setTextColor(TFT_WHITE, TFT_BLACK);
-  Serial.printf("Post-cal CO2 = %d\n", co2.co2_level);
-  y += 30;
-  sprintf(txt, "Post-cal CO2 = %d ppm", co2.co2_level);
-  M5.Lcd.drawString(txt, x, y);
-  y += 30;
-  M5.Lcd.drawString("Press BtnA to exit", x, y);
+  Serial.printf("Put in CO2=%d ppm until the reading settles, or press BtnA when ready.\n", fcal.target);
+  sprintf(txt, "Put in CO2=%d ppm", fcal.target);
+  draw_fcal_line(0, txt, TFT_WHITE);
+  draw_fcal_line(1, "Pre-cal CO2 = wait", TFT_WHITE);
+  draw_fcal_line(4, "BtnB to cancel calibration", TFT_CYAN);
+  fcal_stability.clear();
+  fcal.new_sample = false;
+  fcal.shown_s = UINT32_MAX;
+  fcal.step = fcal_settle;
+  fcal.step_ms = millis();
+}
 
-  do {
-    M5.update();
-    delay(1);
-  } while (!M5.BtnA.wasClicked());
-  M5.Lcd.clear();
+// Show msg on the bottom line (if any) for show_ms, then go back to the main screen
+void end_forced_cal(const char* msg, int32_t colour, uint32_t show_ms) {
+  {
+    Sensor_lock lock;
+    co2.cal_end();
+  }
+  if (msg) draw_fcal_line(fcal_lines - 1, msg, colour);
+  fcal.step = fcal_exit;
+  fcal.step_ms = millis();
+  fcal.exit_ms = show_ms;
+}
+
+// Lines are only drawn when they change, "" blanks one
+void draw_fcal_line(uint8_t line, const char* txt, int32_t colour) {
+  static Text_cache drawn[fcal_lines];
+  int32_t y = fcal_line_y + line * fcal_line_h;
+
+  if (!drawn[line].changed(txt, colour)) return;
+  M5.Lcd.fillRect(0, y, lcd_width, fcal_line_h, TFT_BLACK);
+  M5.Lcd.setFont(&fonts::FreeSans12pt7b);
+  M5.Lcd.setTextDatum(top_left);
+  M5.Lcd.setTextColor(colour);
+  M5.Lcd.setTextPadding(0);
+  M5.Lcd.drawString(txt, 0, y);
 }
 
 /*
@@ -1413,23 +1616,14 @@ void scd_x_forced_cal(uint16_t target_co2) {
 -----------------
 */
 void scd_x_settings(float temp_offs, uint16_t alt, bool ASC) {
-  float _temp_offs = 0.0;
-  uint16_t _alt = 0;
-  bool _ASC = false;
-  bool cmd_ok;
-
   Serial.printf("\n********* Start of function %s() *********\n", __func__);
 
-  cmd_ok = co2.set_co2_device_settings(temp_offs, alt, ASC);
+  // Written by the sensor task between samples, which prints the settings read back
+  Sensor_lock lock;
+  co2.set_co2_device_settings(temp_offs, alt, ASC);
+  Serial.printf("%s settings queued: temperature offset=%.2f °C, altitude=%d, ASC calibration %s\n",
+                co2.name(), temp_offs, alt, ASC == 1 ? "ON" : "OFF");
 
-  if (!cmd_ok)
-    Serial.printf("Error setting %s: temperature offset=%.2f °C, altitude=%d, ASC calibration %s\n",
-                  co2_sensor_type_str, temp_offs, alt, ASC == 1 ? "ON" : "OFF");
-  else {
-    co2.get_co2_device_settings(_temp_offs, _alt, _ASC);
-    Serial.printf("%s Settings OK: temperature offset=%.2f °C, altitude=%d, ASC calibration %s\n",
-                  co2_sensor_type_str, _temp_offs, _alt, _ASC == 1 ? "ON" : "OFF");
-  }
   Serial.println();
   Serial.printf("********* End of function %s() *********\n", __func__);
 }
@@ -1453,25 +1647,17 @@ void start_co2_sensor(bool start_co2) {
 #define dot_gap        5
 #define dot_x_start    85
 
-#if defined SENSOR_IS_SGP30
-  settings_not_applicable = true;
-#endif
-
   Serial.printf("\n********* Start of function %s() *********\n", __func__);
 
   // Display product title
-  M5.Lcd.clear();
+  clear_screen();
   M5.Lcd.setFont(&fonts::FreeSansBold24pt7b);
   M5.Lcd.setTextDatum(top_center);
   M5.Lcd.setTextColor(TFT_YELLOW, TFT_BLACK);
   M5.Lcd.drawString("CO2 Monitor", x, y);
 
   // Display labels
-  y = 57;
   M5.Lcd.setFont(&fonts::FreeSans12pt7b);
-  M5.Lcd.setTextColor(TFT_CYAN, TFT_BLACK);
-  sprintf(txt, "%s settings", co2_sensor_type_str);
-  M5.Lcd.drawString(txt, x, y);
   M5.Lcd.drawRect(10, rect_y, M5.Lcd.width() - 20, 93, TFT_DARKGRAY);
 
   x = 20;
@@ -1487,24 +1673,34 @@ void start_co2_sensor(bool start_co2) {
     M5.Lcd.drawString("Searching for CO2 sensor", x, y);
 
     do {
-      sensor_found = co2.begin();
-      Serial.printf("%s sensor present: %s\n", co2_sensor_type_str, sensor_found ? "Yes" : "No");
+      sensor_found = co2.begin((co2_mode_t)CO2_MODE);
+      Serial.printf("CO2 sensor present: %s\n", sensor_found ? co2.name() : "No");
       M5.Lcd.fillRoundRect(dot_x_start + dot_x, y + 45, dot_width, dot_height, 3, TFT_LIGHTGREY);
       dot_x += (dot_width + dot_gap);
       // delay(100);
     } while (!sensor_found && retries++ < max_retries);
   } else
-    sensor_found = true;
+    sensor_found = co2.sensor() != co2_sensor_none;
 
   // Clear inside the rectangle
   M5.Lcd.fillRect(11, rect_y + 1, M5.Lcd.width() - 22, 91, TFT_BLACK);
 
   // If sensor not found, enter simulation mode
   co2.simulate_co2 = !sensor_found;
+  settings_not_applicable = !co2.has(co2_feature_settings);
+
+  // The sensor type is only known now, it was found on one of the I2C ports
+  x = M5.Lcd.width() / 2;
+  M5.Lcd.setTextDatum(top_center);
+  M5.Lcd.setTextColor(TFT_CYAN, TFT_BLACK);
+  sprintf(txt, "%s settings", co2.simulate_co2 ? "CO2 sensor" : co2.name());
+  M5.Lcd.drawString(txt, x, 57);
+  x = 20;
+  M5.Lcd.setTextDatum(top_left);
 
   y = co2_info_y;
   if (co2.simulate_co2) {
-    Serial.printf("Simulated %s CO2 sensor\n", co2_sensor_type_str);
+    Serial.println("Simulated CO2 sensor");
     M5.Lcd.setTextColor(TFT_RED, TFT_BLACK);
     M5.Lcd.drawString("No CO2 sensor detected", x, y);
     y += co2_info_y_inc;
@@ -1532,17 +1728,20 @@ void start_co2_sensor(bool start_co2) {
 
     M5.Lcd.setTextColor(TFT_CYAN, TFT_BLACK);
 
-    co2.get_co2_device_settings(temp_offset, alt, self_cal);
+    {
+      Sensor_lock lock;
+      co2.get_co2_device_settings(temp_offset, alt, self_cal);  // Last read by the sensor task, no wait on the sensor
+    }
 
     // Display SCD-30 or SCD-41 Automatic Self-Calibration (ASC) setting
     if (co2.simulate_co2) {
       strcpy(txt, "sim");  // Self cal
     } else if (settings_not_applicable) {
       strcpy(txt, "N/A");
-      Serial.printf("No Automatic Self Calibration for %s CO2 sensor\n", co2_sensor_type_str);
+      Serial.printf("No Automatic Self Calibration for %s CO2 sensor\n", co2.name());
     } else {
       sprintf(txt, "%s", self_cal == 1 ? "On" : "Off");  // Self cal
-      Serial.printf("Sensirion %s Auto Self Cal (ASC) is %s\n", co2_sensor_type_str, self_cal ? "ON" : "OFF");
+      Serial.printf("Sensirion %s Auto Self Cal (ASC) is %s\n", co2.name(), self_cal ? "ON" : "OFF");
     }
     M5.Lcd.drawString(txt, x, y);
 
@@ -1552,10 +1751,10 @@ void start_co2_sensor(bool start_co2) {
       strcpy(txt, "sim");  // Self cal
     else if (settings_not_applicable) {
       strcpy(txt, "N/A");
-      Serial.printf("No altitude setting for %s CO2 sensor\n", co2_sensor_type_str);
+      Serial.printf("No altitude setting for %s CO2 sensor\n", co2.name());
     } else {
       sprintf(txt, "%d m", alt);
-      Serial.printf("Sensirion %s altitude is %d m (AMSL)\n", co2_sensor_type_str, alt);
+      Serial.printf("Sensirion %s altitude is %d m (AMSL)\n", co2.name(), alt);
     }
     M5.Lcd.drawString(txt, x, y);
 
@@ -1566,10 +1765,10 @@ void start_co2_sensor(bool start_co2) {
       M5.Lcd.drawString(txt, x, y);  // Temperature offset
     } else if (settings_not_applicable) {
       strcpy(txt, "N/A");
-      Serial.printf("No temperature offset for %s CO2 sensor\n", co2_sensor_type_str);
+      Serial.printf("No temperature offset for %s CO2 sensor\n", co2.name());
       M5.Lcd.drawString(txt, x, y);  // Temperature offset
     } else {
-      Serial.printf("Sensirion %s temperature offset is %.1f°C\n", co2_sensor_type_str, temp_offset);
+      Serial.printf("Sensirion %s temperature offset is %.1f°C\n", co2.name(), temp_offset);
       sprintf(txt, "%1.1f   C", temp_offset);
       M5.Lcd.drawString(txt, x, y);               // Temperature offset
       M5.Lcd.drawCircle(x + 48, y, 4, TFT_CYAN);  // Degree symbol
@@ -1582,6 +1781,24 @@ void start_co2_sensor(bool start_co2) {
   M5.Lcd.setTextColor(TFT_YELLOW, TFT_BLACK);
   M5.Lcd.drawString("Tap screen to continue", x, y);
 
+  // The other sensors are fused with the one above, show how far each is from the fused value so far
+  if (co2.sensors() > 1) {
+    strcpy(txt, "With");
+    for (uint8_t i = 0; i < co2.sensors(); i++) {
+      co2_fusion_stats_t stats;
+      {
+        Sensor_lock lock;
+        stats = co2.fusion_stats(i);
+      }
+      Serial.printf("%s vs fused: %u samples, bias %+.1f ppm, RMS %.1f ppm\n", co2.name(i), stats.samples, stats.bias_ppm, stats.rms_ppm);
+      if (i) sprintf(txt + strlen(txt), " %s", co2.name(i));
+    }
+    M5.Lcd.setTextDatum(bottom_left);
+    M5.Lcd.setTextColor(TFT_DARKGRAY, TFT_BLACK);
+    M5.Lcd.setFont(&fonts::FreeSans9pt7b);
+    M5.Lcd.drawString(txt, 0, M5.Lcd.height());
+  }
+
   // Display software version
   M5.Lcd.setTextDatum(bottom_right);
   M5.Lcd.setTextColor(TFT_DARKGRAY, TFT_BLACK);
@@ -1613,7 +1830,31 @@ void sim_sensor_wrapper(void) {
 
 /*
 -----------------
-  Draw a triangular pointer using rotated sprite on semi-circle gauge
+  Start the simulated CO2 sensor. A trace on the SD card is replayed from its start, otherwise
+  the scenario is played from a day ago into the history, so the bargraphs are already full
+-----------------
+*/
+void start_co2_sim(bool sd_ok) {
+  co2.sim_begin(SIM_SEED, SIM_SCENARIO, co2_sec_per_sample);
+  if (sd_ok && (co2.sim_model.load_csv(SD, sim_csv_path) || co2.sim_model.load_log(SD, sim_log_path))) {
+    Serial.printf("Replaying %d CO2 samples from the SD card\n", co2.sim_model.trace_len());
+  } else {
+    uint16_t co2_level;
+    float temperature, humidity;
+    uint32_t now = history_time(millis());
+    uint32_t t = now > co2_hour_hist_pts * 3600 ? now - co2_hour_hist_pts * 3600 : 0;
+    for (; t < now; t += co2_sec_per_sample)
+      if (co2.sim_model.next(co2_level, temperature, humidity)) co2_hist.add(t, co2_level);
+    Serial.printf("Simulating the %s scenario, seed %d\n", co2.sim_model.name(), SIM_SEED);
+  }
+  co2.sim_sensor();  // First sample now rather than after one period
+  sim.start();
+}
+
+/*
+-----------------
+  Move the semi-circle gauge pointer to a new value, animated by animate_gauge_pointer() over
+  gauge_anim_ms unless jump is true (e.g. the gauge has just been drawn)
   Gauge value is passed in as a percentage:
   0% = 250°
   50% = 0°
@@ -1621,92 +1862,243 @@ void sim_sensor_wrapper(void) {
   angle span = 220°
 -----------------
 */
-void draw_circular_gauge_pointer(uint16_t percent) {
-  uint16_t angle = 0;
-  static uint16_t last_angle = 0;
+void draw_circular_gauge_pointer(uint16_t percent, bool jump) {
+  // calculate the angle based on value in percent
+  if (percent > 100) percent = 100;
+  float angle = 250 + ((220 * percent) / 100);
+
+  if (jump || gauge_anim_ms == 0) {
+    gauge_anim.active = false;
+    gauge_anim.to_angle = angle;
+    draw_gauge_pointer_at(angle);
+    return;
+  }
+  if (angle == gauge_anim.to_angle) return;  // Already there, or on its way
+
+  // Start from wherever the pointer is, even part way through the last animation
+  gauge_anim.from_angle = gauge_anim.angle;
+  gauge_anim.to_angle = angle;
+  gauge_anim.start_ms = millis();
+  gauge_anim.last_frame_ms = gauge_anim.start_ms;
+  gauge_anim.skip_next = false;
+  gauge_anim.frames = 0;
+  gauge_anim.skipped = 0;
+  gauge_anim.active = true;
+}
+
+/*
+-----------------
+  One frame of the gauge pointer animation, called by the TickTwo scheduler every gauge_frame_ms.
+  The pointer's position comes from the time since the animation started, not the number of frames,
+  so it arrives on time even when frames are late (loop() busy) or skipped (last frame over budget).
+  The final position is always drawn.
+-----------------
+*/
+void animate_gauge_pointer(void) {
+  Task_probe probe(gauge_timer);
+  if (!gauge_anim.active) return;
+
+  // Left the gauge screen, it is drawn without animation when it comes back
+  if (display_state != dispaly_gauge || display_init) {
+    gauge_anim.active = false;
+    return;
+  }
+
+  uint32_t now = millis();
+  uint32_t elapsed = now - gauge_anim.start_ms;
+  bool last_frame = elapsed >= gauge_anim_ms;
+
+  // Frames missed while loop() was busy elsewhere
+  uint32_t gap = now - gauge_anim.last_frame_ms;
+  if (gap >= 2 * gauge_frame_ms) gauge_anim.skipped += gap / gauge_frame_ms - 1;
+  gauge_anim.last_frame_ms = now;
+
+  // Give the time back to loop() after a frame that went over budget
+  if (gauge_anim.skip_next && !last_frame) {
+    gauge_anim.skip_next = false;
+    gauge_anim.skipped++;
+    return;
+  }
+
+  // Ease out, fast to start and slowing to a stop on the new value
+  float t = last_frame ? 1.0f : (float)elapsed / gauge_anim_ms;
+  float ease = 1.0f - (1.0f - t) * (1.0f - t) * (1.0f - t);
+
+  uint32_t start_us = micros();
+  draw_gauge_pointer_at(gauge_anim.from_angle + (gauge_anim.to_angle - gauge_anim.from_angle) * ease);
+  gauge_anim.skip_next = micros() - start_us > gauge_frame_budget_us;
+  gauge_anim.frames++;
+
+  if (last_frame) {
+    gauge_anim.active = false;
+    if (debug_mode) Serial.printf("Gauge pointer animation: %d frames drawn, %d skipped\n", gauge_anim.frames, gauge_anim.skipped);
+  }
+}
+
+/*
+-----------------
+  Draw the triangular pointer, a rotated sprite, on the semi-circle gauge at angle
+-----------------
+*/
+void draw_gauge_pointer_at(float angle) {
+  int32_t x, y, w, h;
 
   // Erase the old pointer
-  gauge_pointer.clear(TFT_BLACK);
-  gauge_pointer.pushRotateZoom(arc_x, arc_y, last_angle, 1, 1);
+  if (gauge_face.width() > 0) {
+    // Put back the gauge face under it, only its bounding box is sent to the LCD
+    gauge_pointer_rect(gauge_anim.angle, x, y, w, h);
+    M5.Lcd.setClipRect(x, y, w, h);
+    gauge_face.pushSprite(0, 0);
+    M5.Lcd.clearClipRect();
+  } else {
+    gauge_pointer.clear(TFT_BLACK);
+    gauge_pointer.pushRotateZoom(arc_x, arc_y, gauge_anim.angle, 1, 1);
+  }
 
   // Draw the new pointer sprite
+  gauge_pointer.clear(TFT_BLACK);
   gauge_pointer.fillTriangle(0, 20, gauge_ptr_spr_w / 2, 0, gauge_ptr_spr_w, 20, TFT_WHITE);
 
-  // calculate the angle based on value in percent
-  if (percent > 100) percent = 100;
-  angle = 250 + ((220 * percent) / 100);
+  // Display the pointer sprite, black is transparent so the corners of the sprite don't cover the gauge
+  gauge_pointer.pushRotateZoom(arc_x, arc_y, angle, 1, 1, TFT_BLACK);
+
+  // Remember the current angle to erase on next update
+  gauge_anim.angle = angle;
+}
 
-  // if (angle >= 360) angle -= 360;
+/*
+-----------------
+  LCD rectangle covered by the gauge pointer sprite rotated to angle, plus a pixel each side for rounding
+-----------------
+*/
+void gauge_pointer_rect(float angle, int32_t& x, int32_t& y, int32_t& w, int32_t& h) {
+  float c = cosf(angle * DEG_TO_RAD);
+  float s = sinf(angle * DEG_TO_RAD);
+  float min_x = lcd_width, max_x = 0, min_y = lcd_height, max_y = 0;
+
+  // Rotate the sprite corners about the pivot, which is at (arc_x, arc_y) on the LCD
+  for (uint8_t i = 0; i < 4; i++) {
+    float dx = (i & 1 ? gauge_ptr_spr_w : 0) - gauge_ptr_spr_w / 2;
+    float dy = (i & 2 ? gauge_ptr_spr_h : 0) - (rad_1 - 5);
+    float rx = arc_x + dx * c - dy * s;
+    float ry = arc_y + dx * s + dy * c;
+    if (rx < min_x) min_x = rx;
+    if (rx > max_x) max_x = rx;
+    if (ry < min_y) min_y = ry;
+    if (ry > max_y) max_y = ry;
+  }
+  x = (int32_t)floorf(min_x) - 1;
+  y = (int32_t)floorf(min_y) - 1;
+  w = (int32_t)ceilf(max_x) + 2 - x;
+  h = (int32_t)ceilf(max_y) + 2 - y;
+}
 
-  // Display the pointer sprite
-  gauge_pointer.pushRotateZoom(arc_x, arc_y, angle, 1, 1);
+/*
+-----------------
+  Display run time of loop() and the scheduled tasks, in ms
+    avg, p99, max - run time
+    late          - longest delay of a scheduled task after its interval
+    over          - number of runs over the task's time budget
+-----------------
+*/
+void display_task_timing(void) {
+  char txt[20] = "";
+  int32_t y = 35;
+  const int32_t col_x[] = {130, 185, 240, 290, 318};  // Right hand edge of each column
+  const int32_t col_w[] = {45, 50, 50, 45, 25};        // Text padding, erases the previous value
 
-  // Remember the current angle to erase on next update
-  last_angle = angle;
+  M5.Lcd.setFont(&fonts::FreeSans9pt7b);
+  M5.Lcd.setTextColor(TFT_ORANGE, TFT_BLACK);
+  M5.Lcd.setTextPadding(0);
+  M5.Lcd.setTextDatum(top_left);
+  M5.Lcd.drawString("ms", 5, y);
+  M5.Lcd.setTextDatum(top_right);
+  M5.Lcd.drawString("avg", col_x[0], y);
+  M5.Lcd.drawString("p99", col_x[1], y);
+  M5.Lcd.drawString("max", col_x[2], y);
+  M5.Lcd.drawString("late", col_x[3], y);
+  M5.Lcd.drawString("ovr", col_x[4], y);
+
+  M5.Lcd.setTextColor(TFT_LIGHTGRAY, TFT_BLACK);
+  for (Task_timer* t = Task_timer::first(); t; t = t->next()) {
+    // Run times in 0.1 ms, lateness in ms
+    uint32_t val[] = {(t->avg_us() + 50) / 100, (t->p99_us() + 50) / 100, (t->max_us() + 50) / 100, (t->late_max_us() + 500) / 1000, t->overruns()};
+    y += 22;
+    M5.Lcd.setTextDatum(top_left);
+    M5.Lcd.drawString(t->name(), 5, y);
+    M5.Lcd.setTextDatum(top_right);
+    for (uint8_t i = 0; i < 5; i++) {
+      fmt_fixed(txt, (int32_t)val[i], i < 3 ? 1 : 0);
+      M5.Lcd.setTextPadding(col_w[i]);
+      M5.Lcd.drawString(txt, col_x[i], y);
+    }
+  }
+  M5.Lcd.setTextPadding(0);
+}
+
+/*
+-----------------
+  Display the semi circular gauge scale, from the gauge face sprite if there was memory for it
+-----------------
+*/
+void draw_circular_gauge_scale(void) {
+  if (gauge_face.width() > 0)
+    gauge_face.pushSprite(0, 0);
+  else
+    draw_gauge_face(&M5.Lcd);
 }
 
 /*
 -----------------
-  Draw a semi circular gauge scale for CO2
+  Draw a semi circular gauge scale for CO2, on the LCD or into the gauge face sprite
   fillArc function defines 0° at display EAST, 180° at WEST, 270° at NORTH
   0 = 160°
   max = 20°
   angle span = 220°
 
-  GREEN     CO2 <= 1000
-  YELLOW    CO2 1001-2000
-  RED       CO2 2001-5000
+  One arc per CO2 band (see co2_bands.h) up to gauge_max_ppm, e.g.
+  GREEN     CO2 <= 1000        160° to 248°
+  ORANGE    CO2 1001-2000      248° to 336°
+  RED       CO2 2001-2500      336° to 20° (i.e. 380°-360°)
 -----------------
 */
-void draw_circular_gauge_scale(void) {
+void draw_gauge_face(LovyanGFX* dst) {
   uint16_t start_angle = 160;
   uint16_t end_angle = 0;
 
-  // Start = 160°, End = 160 + (2/5 * 220) = 248°
-  end_angle = start_angle + (2000 * 220) / 5000;
-  M5.Lcd.fillArc(arc_x, arc_y, rad_1, rad_2, start_angle, end_angle, TFT_DARKGREEN);
-  M5.Lcd.drawArc(arc_x, arc_y, rad_1 - 1, rad_2 + 1, start_angle, end_angle, TFT_DARKGREY);
-
-  // Start = 248°, End = 248 + (2/5 * 220) = 336°
-  start_angle = end_angle;
-  end_angle = start_angle + (2000 * 220) / 5000;
-  M5.Lcd.fillArc(arc_x, arc_y, rad_1, rad_2, start_angle, end_angle, TFT_ORANGE);
-  M5.Lcd.drawArc(arc_x, arc_y, rad_1 - 1, rad_2 + 1, start_angle, end_angle, TFT_DARKGREY);
-
-  // Start = 336, End = 336 + (1/5 * 220) = 20° (i.e. 380°-360°)
-  start_angle = end_angle;
-  end_angle = start_angle + (1000 * 220) / 5000;
-  M5.Lcd.fillArc(arc_x, arc_y, rad_1, rad_2, start_angle, end_angle, TFT_RED);
-  M5.Lcd.drawArc(arc_x, arc_y, rad_1 - 1, rad_2 + 1, start_angle, end_angle, TFT_DARKGREY);
+  // Skip the error band, it has no width
+  for (uint8_t b = 1; b < co2_band_count && co2_bands[b - 1].max_ppm < gauge_max_ppm; b++) {
+    uint32_t end_ppm = co2_bands[b].max_ppm < gauge_max_ppm ? co2_bands[b].max_ppm : gauge_max_ppm;
+    end_angle = 160 + (end_ppm * 220) / gauge_max_ppm;
+    dst->fillArc(arc_x, arc_y, rad_1, rad_2, start_angle, end_angle, co2_bands[b].gauge_colour);
+    dst->drawArc(arc_x, arc_y, rad_1 - 1, rad_2 + 1, start_angle, end_angle, TFT_DARKGREY);
+    start_angle = end_angle;
+  }
 
   // Draw scale MINOR tick marks
   uint16_t value = 0;
   uint16_t angle = 0;
   gauge_ticks.clear(TFT_BLACK);
   gauge_ticks.drawRect(0, gauge_tick_spr_h - 3, 2, 3, TFT_LIGHTGREY);
-  for (value = 0; value <= 2500; value += 5) {
-    if (value % 125 == 0) {
-      angle = 250 + ((220 * value) / 2500);
-      gauge_ticks.pushRotateZoom(arc_x, arc_y, angle, 1, 1);
-    }
+  for (value = 0; value <= 2500; value += 125) {
+    angle = 250 + ((220 * value) / 2500);
+    gauge_ticks.pushRotateZoom(dst, arc_x, arc_y, angle, 1, 1);
   }
 
   // Draw scale MAJOR tick marks
   gauge_ticks.drawRect(0, gauge_tick_spr_h - 8, 2, 8, TFT_LIGHTGREY);
-  for (value = 0; value <= 2500; value += 50) {
-    if (value % 250 == 0) {
-      angle = 250 + ((220 * value) / 2500);
-      gauge_ticks.pushRotateZoom(arc_x, arc_y, angle, 1, 1);
-    }
+  for (value = 0; value <= 2500; value += 250) {
+    angle = 250 + ((220 * value) / 2500);
+    gauge_ticks.pushRotateZoom(dst, arc_x, arc_y, angle, 1, 1);
   }
 
-  M5.Lcd.setTextDatum(bottom_centre);
-  M5.Lcd.setFont(&fonts::FreeSans9pt7b);
-  M5.Lcd.setTextColor(TFT_WHITE);
-  M5.Lcd.drawString("0", 40, lcd_height - 35);
-  M5.Lcd.drawString("500", 50, 120);
-  M5.Lcd.drawString("1000", 115, 55);
-  M5.Lcd.drawString("1500", 205, 55);
-  M5.Lcd.drawString("2000", lcd_width - 45, 120);
-  M5.Lcd.drawString("2500", lcd_width - 40, lcd_height - 40);
+  dst->setTextDatum(bottom_centre);
+  dst->setFont(&fonts::FreeSans9pt7b);
+  dst->setTextColor(TFT_WHITE);
+  dst->drawString("0", 40, lcd_height - 35);
+  dst->drawString("500", 50, 120);
+  dst->drawString("1000", 115, 55);
+  dst->drawString("1500", 205, 55);
+  dst->drawString("2000", lcd_width - 45, 120);
+  dst->drawString("2500", lcd_width - 40, lcd_height - 40);
 }
@@ -0,0 +1,103 @@
+//
+//    FILE: ntp_sync.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Non-blocking WiFi connect and NTP sync of the Core2 RTC
+//
+//
+//  HISTORY:
+//  0.0.1   2026-10-16  initial version, replaces the blocking connect_wifi() and sync_rtc_to_ntp()
+//
+
+#include "ntp_sync.h"
+
+#include <M5Unified.h>
+#include <WiFi.h>
+#include <esp_sntp.h>
+
+NTP_sync::NTP_sync(uint32_t wifi_timeout_ms, uint32_t ntp_timeout_ms, uint32_t result_ms) {
+  _wifi_timeout_ms = wifi_timeout_ms;
+  _ntp_timeout_ms = ntp_timeout_ms;
+  _result_ms = result_ms;
+}
+
+// Returns false if a sync is already running
+bool NTP_sync::start(const char *ssid, const char *passwd, const char *tz, const char *server) {
+  if (active()) return false;
+  _tz = tz;
+  _server = server;
+  Serial.println("Starting WiFi");
+  WiFi.begin(ssid, passwd);
+  enter(ntp_wifi_connecting, "WiFi...");
+  return true;
+}
+
+bool NTP_sync::update(void) {
+  const char *old_status = _status;
+  uint32_t in_state_ms = millis() - _state_ms;
+
+  switch (_state) {
+    case ntp_idle:
+      break;
+
+    case ntp_wifi_connecting:
+      if (WiFi.status() == WL_CONNECTED) {
+        Serial.println("WiFi connected, syncing with NTP time");
+        configTzTime(_tz, _server);
+        enter(ntp_waiting, "NTP...");
+      } else if (in_state_ms >= _wifi_timeout_ms) {
+        Serial.println("WiFi not connected");
+        finish(ntp_failed, "No WiFi");
+      }
+      break;
+
+    case ntp_waiting:
+      // Reads back as COMPLETED once, then RESET again
+      if (sntp_get_sync_status() == SNTP_SYNC_STATUS_COMPLETED) {
+        _ntp_second = time(nullptr);
+        enter(ntp_rtc_setting, "NTP...");
+      } else if (in_state_ms >= _ntp_timeout_ms) {
+        Serial.println("No reply from NTP server");
+        finish(ntp_failed, "No NTP");
+      }
+      break;
+
+    case ntp_rtc_setting: {
+      // Synchronise to the start of a second, the RTC only holds whole seconds
+      time_t t = time(nullptr);
+      if (t == _ntp_second) break;
+      struct tm *timeinfo = localtime(&t);  // Convert epoch time to a "tm" structure
+      M5.Rtc.setDateTime(timeinfo);         // Writes the date and time to the Core2's external RTC chip
+      Serial.println("RTC synced to NTP");
+
+#if (CORE_DEBUG_LEVEL == 4)
+      char time_txt[80] = "";
+      strftime(time_txt, 80, "%A %e-%m-%Y, %H:%M:%S", timeinfo);
+      log_d("NTP time is: %s", time_txt);
+#endif
+      finish(ntp_synced, "RTC set");
+      break;
+    }
+
+    case ntp_synced:
+    case ntp_failed:
+      if (in_state_ms >= _result_ms) enter(ntp_idle, "");
+      break;
+  }
+
+  return _status != old_status;
+}
+
+void NTP_sync::enter(ntp_state_t state, const char *status) {
+  _state = state;
+  _status = status;
+  _state_ms = millis();
+}
+
+// WiFi is only needed for the sync, turn it off to save power
+void NTP_sync::finish(ntp_state_t state, const char *status) {
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+  enter(state, status);
+}
@@ -0,0 +1,54 @@
+#pragma once
+//
+//    FILE: ntp_sync.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Non-blocking WiFi connect and NTP sync of the Core2 RTC
+//
+// start() begins the WiFi connection and returns straight away. update() is called from every
+// loop() and moves through the steps below, it never waits, so the CO2 screen and the history
+// keep updating. Each step has a timeout, so a missing access point or NTP server ends in a
+// failed state instead of hanging. WiFi is turned off again when the sync finishes either way.
+//
+//   ntp_wifi_connecting  WiFi.begin() called, wait for WL_CONNECTED
+//   ntp_waiting          configTzTime() called, wait for the SNTP client to set the system time
+//   ntp_rtc_setting      Wait for the next whole second of system time, then write it to the RTC
+//   ntp_synced           Result is shown for result_ms, then back to idle
+//   ntp_failed
+//
+
+#include "Arduino.h"
+
+enum ntp_state_t {
+  ntp_idle,
+  ntp_wifi_connecting,
+  ntp_waiting,
+  ntp_rtc_setting,
+  ntp_synced,
+  ntp_failed,
+};
+
+class NTP_sync {
+ public:
+  NTP_sync(uint32_t wifi_timeout_ms, uint32_t ntp_timeout_ms, uint32_t result_ms);
+  bool start(const char *ssid, const char *passwd, const char *tz, const char *server);
+  bool update(void);  // True when the status text changed
+  bool active(void) const { return _state != ntp_idle; }
+  ntp_state_t state(void) const { return _state; }
+  const char *status(void) const { return _status; }  // Short text for the title bar, e.g. "NTP..."
+
+ private:
+  void enter(ntp_state_t state, const char *status);
+  void finish(ntp_state_t state, const char *status);
+
+  uint32_t _wifi_timeout_ms;
+  uint32_t _ntp_timeout_ms;
+  uint32_t _result_ms;
+  ntp_state_t _state = ntp_idle;
+  const char *_status = "";
+  const char *_tz = nullptr;
+  const char *_server = nullptr;
+  uint32_t _state_ms = 0;  // millis() when the current state was entered
+  time_t _ntp_second = 0;  // System time when ntp_rtc_setting was entered
+};
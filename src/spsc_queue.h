@@ -0,0 +1,63 @@
+#pragma once
+//
+//    FILE: spsc_queue.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Lock-free single producer, single consumer queue for handing data between FreeRTOS tasks
+//
+// Exactly one task calls push() and exactly one other task calls pop(), neither ever blocks. The
+// producer only writes _tail and the consumer only writes _head, each with release ordering, and
+// each reads the other's index with acquire ordering, so an item is fully written before the
+// consumer can see it. Head and tail are free running counters, so a full queue (tail - head == N)
+// is told apart from an empty one (tail == head) without wasting a slot.
+//
+// When the queue is full push() drops the new item and counts it, so a stalled consumer (e.g. a
+// slow LCD update) never holds up the producer. test/test_spsc_queue runs several producer/consumer
+// thread pairs through it, pio test -e native.
+//
+
+#include <stdint.h>
+
+#include <atomic>
+
+template <typename T, uint32_t N>
+class SPSC_queue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SPSC_queue size must be a power of two");
+
+ public:
+  // Producer only. Returns false, and drops the item, if the queue is full
+  bool push(const T &item) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head.load(std::memory_order_acquire) == N) {
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    _buf[tail & (N - 1)] = item;
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. Returns false if the queue is empty
+  bool pop(T &item) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire)) return false;
+    item = _buf[head & (N - 1)];
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Either side, may be out of date as soon as it is read
+  uint32_t count(void) const {
+    uint32_t head = _head.load(std::memory_order_acquire);  // Head first, so tail can't be behind it
+    return _tail.load(std::memory_order_acquire) - head;
+  }
+  uint32_t dropped(void) const { return _dropped.load(std::memory_order_relaxed); }
+  uint32_t capacity(void) const { return N; }
+
+ private:
+  T _buf[N];
+  std::atomic<uint32_t> _head{0};  // Next item to pop, written by the consumer
+  std::atomic<uint32_t> _tail{0};  // Next free slot, written by the producer
+  std::atomic<uint32_t> _dropped{0};
+};
@@ -0,0 +1,109 @@
+//
+//    FILE: task_timing.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Run time and scheduling latency of loop() and the TickTwo tasks
+//
+//
+//  HISTORY:
+//  0.0.1   2026-10-16  initial version
+//
+
+#include "task_timing.h"
+
+#include <algorithm>
+
+Task_timer *Task_timer::_first = nullptr;
+
+Task_timer::Task_timer(const char *name, uint32_t period_ms, uint32_t budget_us) {
+  _name = name;
+  _period_us = period_ms * 1000;
+  _budget_us = budget_us;
+
+  // Append, so the print order is the declaration order
+  Task_timer **p = &_first;
+  while (*p) p = &(*p)->_next;
+  *p = this;
+}
+
+void Task_timer::start(void) {
+  _start_cycles = ESP.getCycleCount();
+  _start_us = micros();
+
+  // Late = time since the last start minus the TickTwo interval
+  if (_period_us && _count) {
+    uint32_t period = _start_us - _last_start_us;
+    uint32_t late = period > _period_us ? period - _period_us : 0;
+    _late_sum_us += late;
+    _late_count++;
+    if (late > _late_max_us) _late_max_us = late;
+  }
+  _last_start_us = _start_us;
+}
+
+void Task_timer::stop(void) {
+  // Cycle counter wraps every 17 s at 240 MHz, fall back to micros() for long runs
+  uint32_t us = micros() - _start_us;
+  if (us < 10000000) us = (ESP.getCycleCount() - _start_cycles) / ESP.getCpuFreqMHz();
+
+  _count++;
+  _sum_us += us;
+  if (us < _min_us) _min_us = us;
+  if (us > _max_us) _max_us = us;
+  if (us > _budget_us) _overruns++;
+  _hist[bucket(us)]++;
+}
+
+void Task_timer::clear(void) {
+  _count = 0;
+  _min_us = UINT32_MAX;
+  _max_us = 0;
+  _sum_us = 0;
+  _overruns = 0;
+  _late_count = 0;
+  _late_sum_us = 0;
+  _late_max_us = 0;
+  memset(_hist, 0, sizeof(_hist));
+}
+
+// Bucket 4 * n + f holds 2^n * (1 + f/4) <= us < 2^n * (1 + (f+1)/4), bucket 0..3 hold 0..3 us
+uint8_t Task_timer::bucket(uint32_t us) {
+  if (us < 4) return us;
+  uint8_t n = 31 - __builtin_clz(us);
+  uint8_t b = 4 * n + ((us >> (n - 2)) & 3);
+  return b < task_hist_buckets ? b : task_hist_buckets - 1;
+}
+
+uint32_t Task_timer::bucket_top_us(uint8_t b) {
+  if (b < 4) return b;
+  uint8_t n = b / 4;
+  return (1UL << n) + ((b % 4 + 1) << (n - 2)) - 1;
+}
+
+// Upper edge of the bucket holding the 99th percentile, within 25% of the true value
+uint32_t Task_timer::p99_us(void) const {
+  uint32_t target = _count - _count / 100;
+  uint32_t seen = 0;
+  for (uint8_t b = 0; b < task_hist_buckets; b++) {
+    seen += _hist[b];
+    if (seen >= target && seen > 0) return std::min(bucket_top_us(b), _max_us);
+  }
+  return _max_us;
+}
+
+/////////////////////////////////////////////////////
+//
+// REPORT
+//
+void task_timing_print(void) {
+  Serial.printf("%-10s %8s %8s %8s %8s %8s %6s %8s %8s\n", "task", "runs", "min_us", "avg_us", "p99_us", "max_us", "over", "late_avg", "late_max");
+  for (Task_timer *t = Task_timer::first(); t; t = t->next())
+    Serial.printf("%-10s %8u %8u %8u %8u %8u %6u %8u %8u\n", t->name(), t->count(), t->min_us(), t->avg_us(), t->p99_us(),
+                  t->max_us(), t->overruns(), t->late_avg_us(), t->late_max_us());
+}
+
+void task_timing_clear(void) {
+  for (Task_timer *t = Task_timer::first(); t; t = t->next())
+    t->clear();
+}
@@ -0,0 +1,74 @@
+#pragma once
+//
+//    FILE: task_timing.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-16
+// PURPOSE: Run time and scheduling latency of loop() and the TickTwo tasks
+//
+// Each Task_timer measures how long its task runs using the CPU cycle counter, and for a
+// periodic task how late it started compared to its TickTwo interval. Run times go into a
+// log scale histogram (4 buckets per power of 2 microseconds) so p99 costs no memory per sample.
+// Put a Task_probe at the top of the function being measured, it stops the timer on every return.
+//
+
+#include "Arduino.h"
+
+#define task_hist_buckets 96  // 24 powers of 2 microseconds (16 s), 4 buckets each
+
+class Task_timer {
+ public:
+  Task_timer(const char *name, uint32_t period_ms, uint32_t budget_us);
+  void start(void);
+  void stop(void);
+  void clear(void);
+
+  const char *name(void) const { return _name; }
+  uint32_t count(void) const { return _count; }
+  uint32_t min_us(void) const { return _count ? _min_us : 0; }
+  uint32_t max_us(void) const { return _max_us; }
+  uint32_t avg_us(void) const { return _count ? (uint32_t)(_sum_us / _count) : 0; }
+  uint32_t p99_us(void) const;
+  uint32_t overruns(void) const { return _overruns; }  // Runs longer than budget_us
+  uint32_t late_avg_us(void) const { return _late_count ? (uint32_t)(_late_sum_us / _late_count) : 0; }
+  uint32_t late_max_us(void) const { return _late_max_us; }
+
+  // All timers, in the order they were created
+  static Task_timer *first(void) { return _first; }
+  Task_timer *next(void) const { return _next; }
+
+ private:
+  static uint8_t bucket(uint32_t us);
+  static uint32_t bucket_top_us(uint8_t b);
+
+  const char *_name;
+  uint32_t _period_us;  // 0 if the task is not periodic
+  uint32_t _budget_us;
+  uint32_t _start_cycles = 0;
+  uint32_t _start_us = 0;
+  uint32_t _last_start_us = 0;
+  uint32_t _count = 0;
+  uint32_t _min_us = UINT32_MAX;
+  uint32_t _max_us = 0;
+  uint64_t _sum_us = 0;
+  uint32_t _overruns = 0;
+  uint32_t _late_count = 0;
+  uint64_t _late_sum_us = 0;
+  uint32_t _late_max_us = 0;
+  uint32_t _hist[task_hist_buckets] = {};
+  Task_timer *_next = nullptr;
+  static Task_timer *_first;
+};
+
+// Times the enclosing scope
+class Task_probe {
+ public:
+  Task_probe(Task_timer &timer) : _timer(timer) { _timer.start(); }
+  ~Task_probe(void) { _timer.stop(); }
+
+ private:
+  Task_timer &_timer;
+};
+
+void task_timing_print(void);
+void task_timing_clear(void);
@@ -0,0 +1,89 @@
+//
+//    FILE: text_format.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: sprintf free number formatting and a last drawn text cache for the LCD
+//
+//
+//  HISTORY:
+//  0.0.1   2026-10-17  initial version
+//
+
+#include "text_format.h"
+
+#include <string.h>
+
+static const uint32_t pow10[] = {1, 10, 100, 1000, 10000, 100000};
+
+char *fmt_uint(char *buf, uint32_t val, uint8_t width, char pad) {
+  char digits[10];
+  uint8_t n = 0;
+  do {
+    digits[n++] = '0' + val % 10;
+    val /= 10;
+  } while (val);
+
+  if (width > fmt_buf_len - 1) width = fmt_buf_len - 1;
+  char *p = buf;
+  for (uint8_t i = n; i < width; i++) *p++ = pad;
+  while (n) *p++ = digits[--n];
+  *p = '\0';
+  return buf;
+}
+
+char *fmt_fixed(char *buf, int32_t val, uint8_t decimals, uint8_t width) {
+  if (decimals > 5) decimals = 5;
+  uint32_t mag = val < 0 ? 0u - (uint32_t)val : (uint32_t)val;
+
+  // Build left aligned, then shift right to pad
+  char *p = buf;
+  if (val < 0) *p++ = '-';
+  fmt_uint(p, mag / pow10[decimals]);
+  if (decimals) {
+    p += strlen(p);
+    *p++ = '.';
+    fmt_uint(p, mag % pow10[decimals], decimals, '0');
+  }
+
+  uint8_t len = strlen(buf);
+  if (width > fmt_buf_len - 1) width = fmt_buf_len - 1;
+  if (len < width) {
+    memmove(buf + width - len, buf, len + 1);
+    memset(buf, ' ', width - len);
+  }
+  return buf;
+}
+
+int32_t fmt_scale(float val, uint8_t decimals) {
+  if (decimals > 5) decimals = 5;
+  val *= pow10[decimals];
+  return (int32_t)(val < 0 ? val - 0.5f : val + 0.5f);
+}
+
+char *fmt_hms(char *buf, uint8_t hours, uint8_t minutes, uint8_t seconds) {
+  fmt_uint(buf, hours, 2, '0');
+  buf[2] = ':';
+  fmt_uint(buf + 3, minutes, 2, '0');
+  buf[5] = ':';
+  fmt_uint(buf + 6, seconds, 2, '0');
+  return buf;
+}
+
+/////////////////////////////////////////////////////
+//
+// LAST DRAWN TEXT
+//
+uint32_t Text_cache::_screen_gen = 1;
+
+bool Text_cache::changed(const char *txt, int32_t colour) {
+  if (_gen == _screen_gen && _colour == colour && strcmp(_txt, txt) == 0) return false;
+
+  if (strlen(txt) < text_cache_len) {
+    strcpy(_txt, txt);
+    _colour = colour;
+    _gen = _screen_gen;
+  } else
+    _gen = 0;  // Too long to remember, always draw it
+  return true;
+}
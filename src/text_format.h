@@ -0,0 +1,52 @@
+#pragma once
+//
+//    FILE: text_format.h
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: sprintf free number formatting and a last drawn text cache for the LCD
+//
+// The display functions run several times a second, and float printf on the ESP32 is slow. These
+// write integers and fixed point values (e.g. 215 with 1 decimal is "21.5") into the caller's
+// buffer, no heap and no floats. Each returns buf, so the result can go straight to drawString().
+//
+// Text_cache remembers the string and colour last drawn in one place on the screen, so a caller
+// only draws when what it would draw has changed. clear_screen() in main.cpp calls
+// Text_cache::clear_all() after clearing the LCD, so everything is drawn again on the new screen.
+//
+
+#include <stdint.h>
+
+#define fmt_buf_len    16  // Big enough for any int32_t with sign, decimal point and padding
+#define text_cache_len 24  // Longest string a Text_cache remembers, longer strings are always drawn
+
+// Right aligned, padded on the left with pad up to width, e.g. fmt_uint(buf, 7, 3) = "  7"
+char *fmt_uint(char *buf, uint32_t val, uint8_t width = 0, char pad = ' ');
+
+// val in units of 10^-decimals, e.g. fmt_fixed(buf, -215, 1) = "-21.5", padded with spaces to width
+char *fmt_fixed(char *buf, int32_t val, uint8_t decimals, uint8_t width = 0);
+
+// Float to the integer fmt_fixed() expects, rounded to nearest, e.g. fmt_scale(21.46, 1) = 215
+int32_t fmt_scale(float val, uint8_t decimals);
+
+// "hh:mm:ss", buf must hold 9 chars
+char *fmt_hms(char *buf, uint8_t hours, uint8_t minutes, uint8_t seconds);
+
+class Text_cache {
+ public:
+  // True if txt or colour differ from the last call, or the screen has been cleared since. The
+  // caller must then draw txt, it is remembered as drawn
+  bool changed(const char *txt, int32_t colour);
+
+  // Forget what was drawn, so the next changed() is true
+  void clear(void) { _gen = 0; }
+
+  // Call after clearing the LCD, every Text_cache draws again
+  static void clear_all(void) { _screen_gen++; }
+
+ private:
+  char _txt[text_cache_len] = "";
+  int32_t _colour = 0;
+  uint32_t _gen = 0;  // _screen_gen when _txt was drawn, 0 = never
+  static uint32_t _screen_gen;
+};
@@ -0,0 +1,66 @@
+//
+//    FILE: test_main.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: co2_to_bargraph_ht() from the lookup tables against the floating point formula it replaced
+//
+// Run with: pio test -e native -f test_bargraph_lut
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include "co2_bargraph_lut.h"
+
+// The bargraph height as co2_to_bargraph_ht() computed it before co2_bargraph_lut.h
+static uint16_t formula_bar_ht(float co2) {
+  if (co2 < 400.0) co2 = 400.0;
+  uint16_t bar_height = (uint16_t)(30.0 * (log(co2) / log(2.0) - 8.64));
+  if (bar_height > co2_bar_ht_max)
+    bar_height = co2_bar_ht_max;
+  return bar_height;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Every uint16_t ppm draws the same bar, reports the first ppm that doesn't
+void test_every_ppm_matches_formula(void) {
+  for (uint32_t ppm = 0; ppm <= 0xFFFF; ppm++) {
+    uint16_t expected = formula_bar_ht((float)ppm);
+    uint16_t actual = co2_to_bargraph_ht((uint16_t)ppm);
+    if (actual != expected) {
+      char msg[40];
+      snprintf(msg, sizeof(msg), "at %u ppm", (unsigned)ppm);
+      TEST_ASSERT_EQUAL_UINT16_MESSAGE(expected, actual, msg);
+    }
+  }
+}
+
+// Each height starts at its co2_bar_ht_ppm[] entry
+void test_height_thresholds(void) {
+  for (uint16_t h = 1; h <= co2_bar_ht_max; h++) {
+    TEST_ASSERT_EQUAL_UINT16(h - 1, co2_to_bargraph_ht(co2_bar_ht_ppm[h] - 1));
+    TEST_ASSERT_EQUAL_UINT16(h, co2_to_bargraph_ht(co2_bar_ht_ppm[h]));
+  }
+}
+
+// A bucket never holds more than one step, so the lookup plus one compare is enough
+void test_one_step_per_bucket(void) {
+  const uint32_t buckets = sizeof(co2_bar_ht_lut) / sizeof(co2_bar_ht_lut[0]);
+  TEST_ASSERT_TRUE(((uint32_t)(co2_bar_ht_ppm[co2_bar_ht_max] - 1 - co2_bar_lut_base_ppm) >> co2_bar_lut_shift) < buckets);
+  for (uint16_t h = 2; h <= co2_bar_ht_max; h++)
+    TEST_ASSERT_TRUE(co2_bar_ht_ppm[h] - co2_bar_ht_ppm[h - 1] > (1 << co2_bar_lut_shift));
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_every_ppm_matches_formula);
+  RUN_TEST(test_height_thresholds);
+  RUN_TEST(test_one_step_per_bucket);
+  return UNITY_END();
+}
@@ -0,0 +1,178 @@
+//
+//    FILE: test_main.cpp
+//  AUTHOR: Patrick Felstead
+// VERSION: 0.0.1
+//    DATE: 2026-10-17
+// PURPOSE: SPSC_queue under several producer/consumer thread pairs at once
+//
+// Each pair has its own queue, one producer thread and one consumer thread, as the sensor task and
+// loop() do. Items are numbered and carry copies of their number, so a consumer sees an item that
+// was lost, repeated, out of order or only half written.
+//
+// Run with: pio test -e native -f test_spsc_queue
+//
+
+#include <stdint.h>
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.h"
+
+#define spsc_test_pairs 4       // Producer/consumer pairs running at once
+#define spsc_test_items 200000  // Items sent by each producer
+#define spsc_test_len   8       // Queue length, small so it is often full, as sensor_queue_len
+
+// Bigger than one word, so a torn copy shows up as a mismatch
+struct spsc_test_item_t {
+  uint32_t seq;
+  uint32_t inv;  // ~seq
+  uint64_t mul;  // seq * a large odd number
+  uint8_t pad[16];
+};
+
+typedef SPSC_queue<spsc_test_item_t, spsc_test_len> spsc_test_queue_t;
+
+struct spsc_test_result_t {
+  uint32_t sent;
+  uint32_t received;
+  uint32_t failed_pushes;
+  uint32_t out_of_order;  // Items not after the last one received, lost ones in lossless mode too
+  uint32_t corrupt;       // Items whose fields don't agree
+  uint32_t dropped;       // SPSC_queue::dropped() at the end
+};
+
+static spsc_test_item_t make_item(uint32_t seq) {
+  spsc_test_item_t item;
+  item.seq = seq;
+  item.inv = ~seq;
+  item.mul = seq * 0x9E3779B97F4A7C15ULL;
+  for (uint8_t i = 0; i < sizeof(item.pad); i++) item.pad[i] = (uint8_t)(seq + i);
+  return item;
+}
+
+static bool item_ok(const spsc_test_item_t &item) {
+  if (item.inv != ~item.seq || item.mul != item.seq * 0x9E3779B97F4A7C15ULL) return false;
+  for (uint8_t i = 0; i < sizeof(item.pad); i++)
+    if (item.pad[i] != (uint8_t)(item.seq + i)) return false;
+  return true;
+}
+
+// One producer/consumer pair. Lossless, the producer retries a full queue until the item goes in
+// and every item must arrive in order. Otherwise the producer drops it and moves on like the sensor
+// task, and the consumer stalls now and then like a slow LCD update. A stall lasts until the
+// producer has found the queue full, so items are dropped however the threads are scheduled
+static void run_pair(spsc_test_queue_t &queue, spsc_test_result_t &result, bool lossless) {
+  std::atomic<bool> done{false};
+  std::atomic<bool> stalled{false};
+  result = {};
+
+  std::thread producer([&] {
+    for (uint32_t seq = 0; seq < spsc_test_items; seq++) {
+      spsc_test_item_t item = make_item(seq);
+      result.sent++;
+      while (!queue.push(item)) {
+        result.failed_pushes++;
+        if (!lossless) {
+          stalled.store(false, std::memory_order_release);
+          break;
+        }
+        std::this_thread::yield();
+      }
+    }
+    done.store(true, std::memory_order_release);
+  });
+
+  std::thread consumer([&] {
+    spsc_test_item_t item;
+    int64_t last = -1;
+    for (;;) {
+      if (!queue.pop(item)) {
+        if (done.load(std::memory_order_acquire) && queue.count() == 0) break;
+        std::this_thread::yield();
+        continue;
+      }
+      result.received++;
+      if (!item_ok(item)) result.corrupt++;
+      if (lossless ? item.seq != last + 1 : (int64_t)item.seq <= last) result.out_of_order++;
+      last = item.seq;
+      if (!lossless && (result.received & 0x3FF) == 0) {
+        stalled.store(true, std::memory_order_release);
+        while (stalled.load(std::memory_order_acquire) && !done.load(std::memory_order_acquire)) std::this_thread::yield();
+      }
+    }
+  });
+
+  producer.join();
+  consumer.join();
+  result.dropped = queue.dropped();
+}
+
+static void run_pairs(bool lossless, spsc_test_result_t *results) {
+  std::vector<spsc_test_queue_t> queues(spsc_test_pairs);
+  std::vector<std::thread> pairs;
+  for (uint8_t i = 0; i < spsc_test_pairs; i++)
+    pairs.emplace_back(run_pair, std::ref(queues[i]), std::ref(results[i]), lossless);
+  for (auto &pair : pairs) pair.join();
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Every item arrives once, in order and intact, however often the queue is full
+void test_lossless_order(void) {
+  spsc_test_result_t results[spsc_test_pairs];
+  run_pairs(true, results);
+  for (uint8_t i = 0; i < spsc_test_pairs; i++) {
+    const spsc_test_result_t &r = results[i];
+    TEST_ASSERT_EQUAL_UINT32(spsc_test_items, r.sent);
+    TEST_ASSERT_EQUAL_UINT32(spsc_test_items, r.received);
+    TEST_ASSERT_EQUAL_UINT32(0, r.out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(0, r.corrupt);
+    TEST_ASSERT_EQUAL_UINT32(r.failed_pushes, r.dropped);  // Each refused push is counted
+  }
+}
+
+// Items that don't fit are dropped and counted, the rest arrive in order and intact
+void test_dropped_counted(void) {
+  spsc_test_result_t results[spsc_test_pairs];
+  run_pairs(false, results);
+  for (uint8_t i = 0; i < spsc_test_pairs; i++) {
+    const spsc_test_result_t &r = results[i];
+    TEST_ASSERT_EQUAL_UINT32(spsc_test_items, r.sent);
+    TEST_ASSERT_EQUAL_UINT32(r.sent, r.received + r.dropped);
+    TEST_ASSERT_EQUAL_UINT32(r.failed_pushes, r.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, r.out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(0, r.corrupt);
+    TEST_ASSERT_TRUE(r.dropped > 0);  // Each consumer stall ends with a full queue
+  }
+}
+
+// Full and empty are told apart without a spare slot
+void test_full_and_empty(void) {
+  spsc_test_queue_t queue;
+  spsc_test_item_t item;
+  TEST_ASSERT_FALSE(queue.pop(item));
+  for (uint32_t seq = 0; seq < spsc_test_len; seq++) TEST_ASSERT_TRUE(queue.push(make_item(seq)));
+  TEST_ASSERT_EQUAL_UINT32(spsc_test_len, queue.count());
+  TEST_ASSERT_FALSE(queue.push(make_item(spsc_test_len)));
+  TEST_ASSERT_EQUAL_UINT32(1, queue.dropped());
+  for (uint32_t seq = 0; seq < spsc_test_len; seq++) {
+    TEST_ASSERT_TRUE(queue.pop(item));
+    TEST_ASSERT_EQUAL_UINT32(seq, item.seq);
+  }
+  TEST_ASSERT_FALSE(queue.pop(item));
+  TEST_ASSERT_EQUAL_UINT32(0, queue.count());
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_full_and_empty);
+  RUN_TEST(test_lossless_order);
+  RUN_TEST(test_dropped_counted);
+  return UNITY_END();
+}